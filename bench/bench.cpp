@@ -0,0 +1,169 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/gpu.h>      // Include GPU library
+#include <gpu/pipeline.h> // Include GPU pipeline library
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* one JSON object per line on stdout; sizes and repetitions come from
+   GPU_BENCH_MIN / GPU_BENCH_MAX / GPU_BENCH_REPS, so a software rasterizer
+   such as Mesa llvmpipe can run a trimmed sweep in CI */
+
+using namespace nodepp;
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace bench {
+
+    struct FORMAT { uint id; const char* name; };
+
+    FORMAT _formats_[] = {
+        { gpu::OUT_UCHAR , "OUT_UCHAR"  }, { gpu::OUT_UCHAR2 , "OUT_UCHAR2"  },
+        { gpu::OUT_UCHAR3, "OUT_UCHAR3" }, { gpu::OUT_UCHAR4 , "OUT_UCHAR4"  },
+        { gpu::OUT_FLOAT , "OUT_FLOAT"  }, { gpu::OUT_FLOAT3 , "OUT_FLOAT3"  },
+        { gpu::OUT_FLOAT4, "OUT_FLOAT4" }, { gpu::OUT_DOUBLE , "OUT_DOUBLE"  },
+        { gpu::OUT_DOUBLE3,"OUT_DOUBLE3"}, { gpu::OUT_DOUBLE4, "OUT_DOUBLE4" }
+    };
+
+    uint get_env( const char* name, uint value ) {
+        auto env = getenv( name ); if( env==nullptr ){ return value; }
+        return (uint) strtoul( env, nullptr, 10 );
+    }
+
+    /* blocks until the GL queue drains so the timers cover real GPU work */
+    void finish() {
+        auto gl = RL::GL::Load();
+        auto fence = gl->FenceSync( RL::GL::SYNC_GPU_COMMANDS, 0 );
+        gl->ClientWaitSync( fence, RL::GL::SYNC_FLUSH_COMMANDS_BIT, 10000000000ULL );
+        gl->DeleteSync( fence );
+    }
+
+    /* deterministic fill so every run uploads the same bytes */
+    gpu::matrix_t get_matrix( uint size, uint format ) {
+        gpu::matrix_t out( size, size, format ); auto raw = out.raw(); uint seed = 12345;
+        for( ulong x=0; x<raw.size(); ++x ){ seed = seed * 1103515245 + 12345; raw[x] = seed >> 24; }
+        if( gpu::get_depth( format )==2 ){ // keep half floats finite
+            for( ulong x=1; x<raw.size(); x+=2 ){ raw[x] &= 0x3B; }
+        } else if( gpu::get_depth( format )==4 ){
+            auto ptr = (float*) &raw; for( ulong x=0; x<raw.size()/4; ++x ){ ptr[x] = ( x % 255 ) / 255.0f; }
+        }   return out;
+    }
+
+    /*─······································································─*/
+
+    void report( const char* name, uint size, const char* format, ptr_t<ulong> times, ulong bytes ) {
+        for( ulong x=0; x<times.size(); ++x ){ for( ulong y=x+1; y<times.size(); ++y ){
+        if ( times[y] < times[x] ){ ulong tmp = times[x]; times[x] = times[y]; times[y] = tmp; }
+        }}
+
+        printf( "{\"bench\":\"%s\",\"width\":%u,\"height\":%u,\"format\":\"%s\","
+                "\"reps\":%lu,\"min_ns\":%lu,\"median_ns\":%lu,\"bytes\":%lu}\n",
+                name, size, size, format, times.size(), times[0], times[ times.size()/2 ], bytes );
+        fflush( stdout );
+    }
+
+    void error( const char* name, uint size, const char* format, string_t message ) {
+        printf( "{\"bench\":\"%s\",\"width\":%u,\"height\":%u,\"format\":\"%s\",\"error\":\"%s\"}\n",
+                name, size, size, format, message.get() );
+        fflush( stdout );
+    }
+
+    /* one warmup call, then `reps` timed ones */
+    template< class T >
+    void run( const char* name, uint size, const char* format, uint reps, ulong bytes, T cb ) {
+        try { cb(); ptr_t<ulong> times( reps, 0UL );
+            for( uint x=0; x<reps; ++x ){
+                 auto time = gpu::stats::now(); cb(); times[x] = gpu::stats::now() - time;
+            }    report( name, size, format, times, bytes );
+        } catch( except_t err ) { error( name, size, format, err.what() ); }
+    }
+
+}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    uint min  = bench::get_env( "GPU_BENCH_MIN" , 2    );
+    uint max  = bench::get_env( "GPU_BENCH_MAX" , 8192 );
+    uint reps = bench::get_env( "GPU_BENCH_REPS", 5    ); if( reps==0 ){ reps = 1; }
+    if ( max > gpu::get_max_texture_size() ){ max = gpu::get_max_texture_size(); }
+
+    for( uint size=min; size>0 && size<=max; size*=4 ){ for( auto& fmt: bench::_formats_ ){
+
+        auto input = bench::get_matrix( size, fmt.id );
+        ulong bytes= input.raw().size();
+
+        bench::run( "upload", size, fmt.name, reps, bytes, [&](){
+            input.raw(); input.get(); bench::finish();
+        });
+
+        gpu::gpu_t copy( GPU_KERNEL( return texture( image, uv / size ); ));
+        copy.set_output( size, size, fmt.id )
+            .set_input ( gpu::vec2_t({ (float) size, (float) size }), "size" )
+            .set_input ( input, "image" );
+
+        bench::run( "compile", size, fmt.name, reps, 0, [&](){
+            gpu::cache::clear(); copy.compile();
+        });
+
+        bench::run( "dispatch", size, fmt.name, reps, 0, [&](){
+            copy.render(); bench::finish();
+        });
+
+        bench::run( "readback", size, fmt.name, reps, bytes, [&](){
+            gpu::matrix_t out( copy.get() );
+        });
+
+        bench::run( "dispatch+readback", size, fmt.name, reps, bytes, [&](){
+            copy();
+        });
+
+        if( gpu::get_depth( fmt.id )==1 ){
+        bench::run( "get_canvas", size, fmt.name, reps, bytes, [&](){
+            gpu::get_canvas( input );
+        }); }
+
+        /*─··································································─*/
+
+        if( fmt.id!=gpu::OUT_UCHAR4 && fmt.id!=gpu::OUT_DOUBLE4 ){ continue; }
+
+        gpu::gpu_t multiply( GPU_KERNEL( // example/hello_world.cpp
+            vec2 idx = uv / size; return vec4( vec3( texture( image, idx ).x * texture( image, idx ).y ), 1.0 );
+        ));
+        multiply.set_output( size, size, fmt.id )
+                .set_input ( gpu::vec2_t({ (float) size, (float) size }), "size" )
+                .set_input ( input, "image" );
+
+        bench::run( "example/multiply", size, fmt.name, reps, 0, [&](){
+            multiply.render(); bench::finish();
+        });
+
+        gpu::gpu_t convolution( GPU_KERNEL( // example/convolution.cpp
+            vec2 px = 1.0 / size; vec4 sum = vec4( 0.0 );
+            for( int y=-1; y<=1; y++ ){ for( int x=-1; x<=1; x++ ){
+                 sum += texture( image, ( uv + vec2( x, y ) ) * px ) * float( -x );
+            }}   return vec4( clamp( ( sum.xyz + 2.0 ) / 4.0, 0.0, 1.0 ), 1.0 );
+        ));
+        convolution.set_output( size, size, fmt.id )
+                   .set_input ( gpu::vec2_t({ (float) size, (float) size }), "size" )
+                   .set_input ( input, "image" );
+
+        bench::run( "example/convolution", size, fmt.name, reps, 0, [&](){
+            convolution.render(); bench::finish();
+        });
+
+        gpu::pipeline_t pipeline; pipeline.add( convolution, "image", 4 ); // example/pipeline.cpp
+
+        bench::run( "example/pipeline", size, fmt.name, reps, 0, [&](){
+            pipeline.render( input ); bench::finish();
+        });
+
+    }}
+
+    printf( "{\"stats\":%s}\n", gpu::stats::to_json().get() );
+    gpu::stop_machine();
+
+}
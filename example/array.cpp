@@ -0,0 +1,29 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/array.h>    // Include GPU array library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    ulong size = 1000000; // One million elements, packed 4 per texel
+
+    ptr_t<float> a( size, 0.0f ), b( size, 0.0f );
+    for( ulong x=0; x<size; ++x ){ a[x] = x; b[x] = 0.5f; }
+
+    gpu::kernel_t kernel( GPU_KERNEL( // Element-wise multiply-add, gpu.js style
+        return a_get( thread.x ) * b_get( thread.x ) + 1.0;
+    ));
+
+    kernel.set_output( size );            // 1D output of the same length
+    kernel.set_input ( gpu::flat_t( a ), "a" );
+    kernel.set_input ( gpu::flat_t( b ), "b" );
+
+    auto out = kernel().data();           // Unpacked back into a flat array
+    console::log( out[0], out[1], out[size-1] );
+
+    gpu::stop_machine();
+
+}
@@ -0,0 +1,32 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/batch.h>    // Include GPU batch library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    // textureSize() and the texture coordinates are local to each job
+    gpu::batch_t batch( GPU_KERNEL(
+        vec2 idx = uv / vec2( textureSize( image, 0 ) );
+        float c  = texture( image, idx ).x;
+        return vec4( vec3( c * 2. ), 1. );
+    ), gpu::OUT_DOUBLE4 );
+
+    ptr_t<uint> done = new uint( 0 ); uint jobs = 256;
+
+    for( uint x=0; x<jobs; ++x ){ // queued in this turn, drawn together on the next
+
+        uint width = 2 + x % 3; // jobs of 2x2, 3x2 and 4x2 share one atlas
+        gpu::matrix_t image( width, 2, ptr_t<float>( width * 2, x / 256. ) );
+
+        batch.add( image, "image" ).then([=]( gpu::matrix_t output ){
+            if( x==1 ){ for( auto y: output.to_float() ){ console::log( y ); } }
+            if( ++*done==jobs ){ console::log( batch.get_stats().draws, "draw(s)" ); gpu::stop_machine(); }
+        }).fail([=]( except_t err ){ console::log( err.what() ); });
+
+    }
+
+}
@@ -0,0 +1,29 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/conv.h>     // Include GPU convolution library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::matrix_t image( "image.png" );
+
+    uint  size = 31; ptr_t<float> box( size * size, 1.0f / ( size * size ) );
+    auto  blur = gpu::conv::convolve( image, size, size, box, gpu::OUT_UCHAR4 ); // rank-1: two 31-tap passes
+
+    ptr_t<float> ring( size * size, 0.0f ); float sum = 0; // Not separable: FFT path
+    for( uint y=0; y<size; ++y ){ for( uint x=0; x<size; ++x ){
+         float d = hypot( x - 15.0f, y - 15.0f ); if( d>15 || d<12 ){ continue; }
+         ring[ y * size + x ] = 1; sum++;
+    }}   for( ulong x=0; x<ring.size(); ++x ){ ring[x] /= sum; }
+
+    auto bokeh = gpu::conv::convolve( image, size, size, ring, gpu::OUT_UCHAR4 );
+
+    gpu::save_canvas( blur , "blur.png"  );
+    gpu::save_canvas( bokeh, "bokeh.png" );
+
+    gpu::stop_machine();
+
+}
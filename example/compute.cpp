@@ -0,0 +1,47 @@
+#include <nodepp/nodepp.h>
+#include <gpu/gpu.h>
+#include <gpu/compute.h>
+
+using namespace nodepp;
+
+void onMain() {
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    if( !gpu::compute::has_compute() )
+      { throw except_t("compute shaders need a GL 4.3 context"); }
+
+    // one workgroup of 256 invocations folds 256 values through shared memory
+    gpu::compute_t sum ( GPU_KERNEL(
+
+        uint i = gl_LocalInvocationID.x;
+        uint g = gl_WorkGroupID.x * gl_WorkGroupSize.x + i;
+
+        tile[i] = g < uint( count ) ? values[g] : vec4( 0.0 );
+        barrier();
+
+        for( uint s = gl_WorkGroupSize.x / 2u; s > 0u; s >>= 1 ){
+            if( i < s ){ tile[i] += tile[i + s]; } barrier();
+        }
+
+        if( i == 0u ){ gpu_output[ gl_WorkGroupID.x ] = tile[0]; }
+
+    ));
+
+    ulong n = 4096; ptr_t<gpu::vec4_t> data( n, gpu::vec4_t({ 1, 2, 3, 4 }) );
+    gpu::matrix_t values( n, 1, data );
+
+    sum.set_local_size( 256 )
+       .add_shared    ( "vec4 tile[256]" )
+       .set_output    ( n / 256, 1, gpu::OUT_DOUBLE4 )
+       .set_input     ( values, "values" )
+       .set_input     ( (int) n, "count" );
+
+    auto out = sum.dispatch( n / 256 ).get().to_float();
+    for( ulong x=0; x<out.size(); x+=4 )
+       { console::log( out[x], out[x+1], out[x+2], out[x+3] ); }
+
+    gpu::stop_machine();
+
+}
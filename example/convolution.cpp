@@ -13,16 +13,16 @@ void onMain(){
         vec4 sum = vec4( 0.0 );      // Accumulator for convolution
         vec2 uv_norm = uv / size;    // Normalized UV coordinates
         
-        for( int y=0; y<3; y++ ){    // Loop through 3x3 filter rows
-        for( int x=0; x<3; x++ ){    // Loop through 3x3 filter columns
+        for( int y=0; y<FILTER_SIZE; y++ ){ // Constant bounds, unrolled by the driver
+        for( int x=0; x<FILTER_SIZE; x++ ){
                 
             // Calculate centered image offset
-            vec2 image_offset = vec2(x, y) - 1.0;
+            vec2 image_offset = vec2(x, y) - float( FILTER_SIZE / 2 );
             vec2 image_coord  = uv_norm + image_offset*pixel_size;
             vec3 image_val    = texture( image, image_coord ).xyz;
 
             // Calculate filter texture coordinates
-            vec2 fltr_coord = (vec2(x, y) + 0.5) / 3.0;
+            vec2 fltr_coord = (vec2(x, y) + 0.5) / float( FILTER_SIZE );
             vec3 fltr_val   = texture( fltr, fltr_coord ).xyz;
 
             // Multiply image and filter values, add to sum
@@ -48,6 +48,7 @@ void onMain(){
     }));
 
     gpu.set_output( image.width(), image.height(), gpu::OUT_UCHAR4 ); // Set output dimensions and format
+    gpu.set_constant( "FILTER_SIZE", 3 ); // Compiled in as a #define, not a uniform
     gpu.set_input ( filter, "fltr"  ); // Bind filter matrix to kernel
     gpu.set_input ( image , "image" ); // Bind image matrix to kernel
     gpu.set_input ( gpu::uvec2_t({     // Pass image size as a uniform
@@ -55,7 +56,7 @@ void onMain(){
         image.height()
     }), "size" );
 
-    gpu::save_canvas( gpu().get(), "output.png" ); // Execute kernel and save output
+    gpu::save_canvas( gpu(), "output.png" ); // Execute kernel and save output
 
     gpu::stop_machine(); // Clean up GPU resources
 
@@ -0,0 +1,58 @@
+#include <nodepp/nodepp.h>
+#include <gpu/gpu.h>
+#include <gpu/cpu.h>
+#include <gpu/reduce.h>
+
+using namespace nodepp;
+
+void onMain() {
+
+    // no GPU on this node: every job below runs on gpu::cpu instead
+    if( !gpu::start_machine() )
+      { console::log("GPU machine not available, using the CPU backend"); }
+
+    gpu::gpu_t gpu ( GPU_KERNEL(
+
+        vec2 idx = uv / vec2( 2, 2 );
+
+        float color_a = texture( image_a, idx ).x;
+        float color_b = texture( image_b, idx ).x;
+        float color_c = color_a * color_b;
+
+        return vec4( vec3( color_c ), 1. );
+
+    ));
+
+    // the same job as a C++ lambda, used whenever no GL context exists;
+    // sampler names are resolved once per job, not once per texel
+    gpu.set_fallback( gpu::cpu::kernel([]( const gpu::cpu_t& ctx ){
+        return gpu::ivec2_t({ ctx.sampler( "image_a" ), ctx.sampler( "image_b" ) });
+    }, []( const gpu::cpu_t& ctx, gpu::ivec2_t id, uint x, uint y ){
+        float color_c = ctx.fetch( id.x, x, y ).x() * ctx.fetch( id.y, x, y ).x();
+        return gpu::texel_t( color_c, color_c, color_c, 1. );
+    }));
+
+    gpu::matrix_t matrix_a( 2, 2, ptr_t<float>({
+        10., 10.,
+        10., 10.,
+    }) );
+
+    gpu::matrix_t matrix_b( 2, 2, ptr_t<float>({
+        .1, .2,
+        .4, .3,
+    }) );
+
+    gpu.set_output(2, 2, gpu::OUT_DOUBLE4);
+    gpu.set_input (matrix_a, "image_a");
+    gpu.set_input (matrix_b, "image_b");
+
+    for( auto x: gpu().to_float() )
+       { console::log(x); }
+
+    // built-in primitives pick the CPU path on their own
+    auto sum = gpu::reduce::sum( matrix_b );
+    console::log( "sum:", sum.x );
+
+    gpu::stop_machine();
+
+}
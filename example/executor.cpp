@@ -0,0 +1,28 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/executor.h> // Include GPU executor library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::gpu_t invert( GPU_KERNEL(
+        vec4 c = texture( image, uv / size );
+        return vec4( 1.0 - c.xyz, c.w );
+    ));
+
+    gpu::matrix_t image( "image.png" ); // Decoded on this thread, uploaded on the worker
+    invert.set_output( image.width(), image.height(), gpu::OUT_UCHAR4 ); // Allocates, so before start()
+    invert.set_input ( gpu::vec2_t({ (float) image.width(), (float) image.height() }), "size" );
+    invert.set_input ( image, "image" );
+
+    gpu::executor_t executor; executor.start(); // The GL context now lives on the worker
+
+    executor.dispatch( invert ).then([=]( gpu::matrix_t output ){
+        gpu::save_canvas( output, "output.png" ); // PNG encode overlaps the next GPU batch
+        executor.close(); gpu::stop_machine();
+    }).fail([=]( except_t err ){ console::log( err.what() ); });
+
+}
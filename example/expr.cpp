@@ -0,0 +1,27 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/expr.h>     // Include GPU expression library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::matrix_t a( 2, 2, ptr_t<float>({ 1., 2., 3., 4. }) );
+    gpu::matrix_t b( 2, 2, ptr_t<float>({ .5, .5, 2., -1. }) );
+    gpu::matrix_t c( 2, 2, ptr_t<float>({ 1., 1., 1., 1. }) );
+
+    // nothing runs yet: this only builds the expression tree
+    gpu::expr_t expr = gpu::expr::clamp( a * b + c, 0., 3. ) / 2.;
+
+    console::log( expr.get_source() ); // the fused GLSL expression
+
+    gpu::matrix_t out = expr; // one kernel, no intermediate textures
+
+    for( auto x: out.to_float() )
+       { console::log( x ); }
+
+    gpu::stop_machine();
+
+}
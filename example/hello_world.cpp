@@ -34,7 +34,7 @@ void onMain() {
     gpu.set_input (matrix_a, "image_a");
     gpu.set_input (matrix_b, "image_b");
 
-    for( auto x: gpu().data() ) 
+    for( auto x: gpu().to_float() ) 
        { console::log(x); }
 
     gpu::stop_machine();
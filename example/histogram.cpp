@@ -0,0 +1,27 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/scatter.h>  // Include GPU scatter library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::matrix_t image( "image.png" );
+
+    auto hist = gpu::histogram( image, 256 ).to_float(); // 256 bins x RGBA counts, no full readback
+    for( uint x=0; x<256; x+=32 ){ console::log( x, hist[x*4], hist[x*4+1], hist[x*4+2] ); }
+
+    gpu::scatter_t splat( GPU_KERNEL( // Custom scatter: accumulate brightness by position
+        return vec2( id ) / 8.0;
+    ), GPU_KERNEL(
+        return vec4( dot( v.xyz, vec3( 0.299, 0.587, 0.114 ) ), 0.0, 0.0, 1.0 );
+    ));
+
+    splat.set_output( image.width() / 8, image.height() / 8, gpu::OUT_DOUBLE4 );
+    auto blocks = splat( image ); // .x sum of luma, .w pixel count per 8x8 block
+
+    gpu::stop_machine();
+
+}
@@ -54,7 +54,9 @@ void gpu_convolution( string_t data, string_t ext ){
         image.height()
     }), "size" );
 
-    gpu::save_canvas( gpu().get(), "output.png" ); // Execute kernel and save output
+    gpu.run_async().then([=]( gpu::matrix_t output ){ // Execute kernel without blocking the event loop
+        gpu::save_canvas( output, "output.png" );       // Save output once the readback lands
+    });
 
 }
 
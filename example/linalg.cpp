@@ -0,0 +1,41 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/linalg.h>   // Include GPU linear algebra library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    uint m = 64, k = 48, n = 32, batch = 8;
+
+    ptr_t<float> a( batch * m * k, 0.0f ), b( k * n, 0.0f );
+    for( ulong x=0; x<a.size(); ++x ){ a[x] = ( x % 7 ) * 0.25f; }
+    for( ulong x=0; x<b.size(); ++x ){ b[x] = ( x % 5 ) * 0.50f; }
+
+    gpu::dense_t A( batch * m, k, a ); // 8 matrices of 64x48 stacked vertically
+    gpu::dense_t B( k, n, b );         // one 48x32 matrix shared by every batch
+
+    auto C = gpu::linalg::matmul( A, B, batch );     // 512x32, one pass
+    auto T = gpu::linalg::transpose( C );            // 32x512
+
+    // the same products on the CPU path, compared element by element
+    auto refC = gpu::cpu::matmul( A.get(), B.get(), m, k, false );
+    auto refT = gpu::cpu::transpose( refC, C.rows(), C.cols() );
+
+    auto check = [&]( gpu::dense_t lhs, gpu::dense_t rhs ){
+        auto x = lhs.data(), y = rhs.data(); float err = 0.0f;
+        for( ulong i=0; i<x.size(); ++i ){ float d = fabsf( x[i] - y[i] ); if( d>err ){ err = d; } }
+        return err;
+    };
+
+    float errC = check( C, gpu::dense_t( refC, C.rows(), C.cols() ) );
+    float errT = check( T, gpu::dense_t( refT, T.rows(), T.cols() ) );
+
+    console::log( C.rows(), C.cols(), T.rows(), T.cols(), "max error:", errC, errT );
+    if( errC>1e-3f || errT>1e-3f ){ throw except_t( "gpu and cpu results differ" ); }
+
+    gpu::stop_machine();
+
+}
@@ -0,0 +1,33 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/gpu.h>      // Include GPU library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::matrix_t image( "image.png" );
+
+    gpu::gpu_t gradient( GPU_KERNEL( // One pass, four results per pixel
+        vec2  px = 1.0 / size;
+        float gx = texture( image, ( uv + vec2( 1, 0 ) ) * px ).x - texture( image, ( uv - vec2( 1, 0 ) ) * px ).x;
+        float gy = texture( image, ( uv + vec2( 0, 1 ) ) * px ).x - texture( image, ( uv - vec2( 0, 1 ) ) * px ).x;
+        magnitude   = vec4( vec3( length( vec2( gx, gy ) ) ), 1.0 );
+        orientation = vec4( vec3( atan( gy, gx ) ), 1.0 );
+        return vec4( gx, gy, 0.0, 1.0 );
+    ));
+
+    gradient.set_output( image.width(), image.height(), gpu::OUT_DOUBLE4 );
+    gradient.add_output( "magnitude"  , gpu::OUT_UCHAR4  );
+    gradient.add_output( "orientation", gpu::OUT_DOUBLE4 );
+    gradient.set_input ( gpu::vec2_t({ (float) image.width(), (float) image.height() }), "size" );
+    gradient.set_input ( image, "image" );
+
+    auto out = gradient.outputs(); // "output", "magnitude" and "orientation"
+    gpu::save_canvas( out["magnitude"], "magnitude.png" );
+
+    gpu::stop_machine();
+
+}
@@ -0,0 +1,49 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/pipeline.h> // Include GPU pipeline library
+
+using namespace nodepp;
+
+void onMain(){
+
+    gpu::start_machine(); // Initialize GPU machine
+
+    gpu::matrix_t image ( "image.png" ); // Load input image
+    gpu::uvec2_t  size ({ image.width(), image.height() });
+
+    gpu::gpu_t blur( GPU_KERNEL( // Box blur, run several times in ping-pong
+        vec2 px = 1.0 / size; vec4 sum = vec4( 0.0 );
+        for( int y=-1; y<=1; y++ ){ for( int x=-1; x<=1; x++ ){
+             sum += texture( image, ( uv + vec2( x, y ) ) * px );
+        }}   return sum / 9.0;
+    ));
+
+    gpu::gpu_t edge( GPU_KERNEL( // Horizontal gradient magnitude
+        vec2 px = 1.0 / size;
+        vec3 a  = texture( image, ( uv - vec2( 1, 0 ) ) * px ).xyz;
+        vec3 b  = texture( image, ( uv + vec2( 1, 0 ) ) * px ).xyz;
+        return vec4( abs( b - a ), 1.0 );
+    ));
+
+    gpu::gpu_t threshold( GPU_KERNEL( // Binary threshold
+        float v = texture( image, uv / size ).x;
+        return vec4( vec3( step( 0.1, v ) ), 1.0 );
+    ));
+
+    blur.set_name( "blur" ); edge.set_name( "edge" ); threshold.set_name( "threshold" );
+
+    for( auto x: { &blur, &edge, &threshold } ){
+         x->set_output( image.width(), image.height(), gpu::OUT_UCHAR4 );
+         x->set_input ( size, "size" );
+    }
+
+    gpu::pipeline_t pipeline; pipeline
+        .add( blur, "image", 4 ) // 4 blur iterations without leaving the GPU
+        .add( edge, "image"    )
+        .add( threshold, "image" );
+
+    gpu::save_canvas( pipeline( image ), "output.png" ); // Only the final stage is read back
+    console::log( gpu::stats::to_json() ); // Per-kernel draw, upload and readback timings
+
+    gpu::stop_machine(); // Clean up GPU resources
+
+}
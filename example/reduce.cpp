@@ -0,0 +1,27 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/reduce.h>   // Include GPU reduction library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    gpu::matrix_t image( "image.png" ); // Load input image
+
+    auto mean = gpu::reduce::mean  ( image ); // Per-channel average, 1 texel read back
+    auto peak = gpu::reduce::argmax( image ); // Brightest red pixel
+    console::log( mean.x, mean.y, mean.z, peak.x, peak.y );
+
+    gpu::reduce_t luma( // Custom combine with a map stage and a per-row axis
+        "return a + b;", "return vec4( dot( v.xyz, vec3( 0.299, 0.587, 0.114 ) ) );",
+        gpu::REDUCE_ROW
+    );
+
+    auto rows = luma( image ).to_float(); // One RGBA texel per image row
+    console::log( rows[0] / image.width() );
+
+    gpu::stop_machine();
+
+}
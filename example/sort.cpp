@@ -0,0 +1,26 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/scan.h>     // Include GPU scan and sort library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    uint w = 1024, h = 1024; // One million scored candidates: .x score, .y id
+    ptr_t<gpu::vec4_t> data( w * h, gpu::vec4_t({ 0, 0, 0, 0 }) );
+    for( ulong x=0; x<data.size(); ++x ){
+         data[x] = gpu::vec4_t({ (float) ( ( x * 7919 ) % 10007 ), (float) x, 0, 0 });
+    }
+
+    gpu::matrix_t candidates( w, h, data );
+
+    auto ranked = gpu::sort( candidates, true ).to_float();      // Highest score first
+    auto keep   = gpu::scan( candidates, true ).to_float();      // Exclusive running sum of every lane
+
+    console::log( ranked[0], ranked[1], keep[4], keep[8] );
+
+    gpu::stop_machine();
+
+}
@@ -0,0 +1,47 @@
+#include <nodepp/nodepp.h>// Include nodepp library
+#include <gpu/stream.h>   // Include GPU stream library
+
+using namespace nodepp;
+
+void onMain(){
+
+    if( !gpu::start_machine() )
+      { throw except_t("Failed to start GPU machine"); }
+
+    uint width = 640, height = 480, frames = 120;
+
+    gpu::gpu_t invert( GPU_KERNEL(
+        vec4 c = texture( image, uv / size );
+        return vec4( 1.0 - c.xyz, c.w );
+    ));
+
+    invert.set_output( width, height, gpu::OUT_UCHAR4 );
+    invert.set_input ( gpu::vec2_t({ (float) width, (float) height }), "size" );
+
+    // up to 3 frames between upload and readback
+    gpu::stream_t stream( invert, "image", 3 );
+
+    ptr_t<uint> sent = new uint( 0 ), done = new uint( 0 );
+
+    // stands in for a decoder: writes until the stream pushes back
+    function_t<void> produce = [=](){
+        while( *sent < frames ){ gpu::matrix_t frame( width, height, gpu::OUT_UCHAR4 );
+            auto raw = frame.raw(); memset( &raw, *sent % 256, raw.size() ); ++*sent;
+            if( !stream.write( frame ) ){ return; }
+        }   stream.end();
+    };
+
+    stream.onDrain.on( produce );
+
+    stream.onData.on([=]( gpu::matrix_t frame ){ ++*done; }); // hand off to an encoder here
+
+    stream.onError.on([=]( except_t err ){ console::log( err.what() ); });
+
+    stream.onClose.on([=](){
+        console::log( *done, "frames processed" );
+        gpu::stop_machine();
+    });
+
+    produce();
+
+}
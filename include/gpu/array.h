@@ -0,0 +1,196 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_ARRAY
+#define NODEPP_GPU_ARRAY
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class flat_t {
+protected:
+
+    struct NODE {
+        ulong x=0, y=1, z=1;
+        matrix_t matrix;
+    };  ptr_t<NODE> obj;
+
+    void set_data( ulong x, ulong y, ulong z, const ptr_t<float>& data ) {
+
+        if( x * y * z != data.size() )
+          { throw except_t( "array ptr size must be", x * y * z ); }
+
+        uint w, h; get_layout( data.size(), w, h );
+        obj->x = x; obj->y = y; obj->z = z;
+
+        ptr_t<uchar> raw( (ulong) w * h * 4 * sizeof(float), 0x00 );
+        memcpy( &raw, &data, data.size() * sizeof(float) );
+        obj->matrix = matrix_t( w, h, raw, OUT_DOUBLE4 );
+
+    }
+
+public:
+
+    /* packs 4 elements per RGBA texel into the smallest near-square texture */
+    static void get_layout( ulong length, uint& width, uint& height ) noexcept {
+        ulong texels = ( length + 3 ) / 4; if( texels==0 ){ texels=1; }
+        width  = (uint) ceil( sqrt( (double) texels ) );
+        height = (uint) ( ( texels + width - 1 ) / width );
+    }
+
+    /*─······································································─*/
+
+    flat_t( ptr_t<float> data ) : obj( new NODE() ) {
+        set_data( data.size(), 1, 1, data );
+    }
+
+    flat_t( ulong x, ulong y, ptr_t<float> data ) : obj( new NODE() ) {
+        set_data( x, y, 1, data );
+    }
+
+    flat_t( ulong x, ulong y, ulong z, ptr_t<float> data ) : obj( new NODE() ) {
+        set_data( x, y, z, data );
+    }
+
+    flat_t( matrix_t packed, ulong x, ulong y=1, ulong z=1 ) : obj( new NODE() ) {
+        if( packed.format()!=OUT_DOUBLE4 ){ throw except_t( "invalid packed array" ); }
+        if( (ulong) packed.width() * packed.height() * 4 < x * y * z )
+          { throw except_t( "invalid packed array" ); }
+        obj->x = x; obj->y = y; obj->z = z; obj->matrix = packed;
+    }
+
+    flat_t() noexcept : obj( new NODE() ){}
+
+    /*─······································································─*/
+
+    ulong size() const noexcept { return obj->x * obj->y * obj->z; }
+    ulong x   () const noexcept { return obj->x; }
+    ulong y   () const noexcept { return obj->y; }
+    ulong z   () const noexcept { return obj->z; }
+
+    matrix_t get() const noexcept { return obj->matrix; }
+
+    ptr_t<float> data() const noexcept {
+        ptr_t<float> out( size(), 0x00 ); if( size()==0 ){ return out; }
+        memcpy( &out, obj->matrix.get_image().data, size() * sizeof(float) );
+        return out;
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { string_t _array_kernel_=GPU_KERNEL(
+    float kernel( ivec3 thread ){ ${0} }
+);}}
+
+namespace nodepp { namespace gpu { string_t _array_fetch_=GPU_KERNEL(
+    float ${0}_get( int i ){
+        int t = i / 4; int c = i - t * 4;
+        int w = int( ${0}_size.x ); int ty = t / w; int tx = t - ty * w;
+        vec4 v = texture( ${0}, ( vec2( tx, ty ) + 0.5 ) / ${0}_size );
+        return c==0 ? v.x : c==1 ? v.y : c==2 ? v.z : v.w;
+    }
+    float ${0}_get( int x, int y ){ return ${0}_get( y * ${0}_shape.x + x ); }
+    float ${0}_get( int x, int y, int z ){
+        return ${0}_get( ( z * ${0}_shape.y + y ) * ${0}_shape.x + x );
+    }
+);}}
+
+namespace nodepp { namespace gpu { string_t _array_main_=GPU_KERNEL(
+    int base = ( int( uv.y ) * gpu_width + int( uv.x ) ) * 4;
+    int size = shape.x * shape.y * shape.z; vec4 res = vec4( 0.0 );
+    for( int k=0; k<4; k++ ){ int i = base + k; if( i>=size ){ break; }
+        int r = i / shape.x; int x = i - r * shape.x;
+        int z = r / shape.y; int y = r - z * shape.y;
+        float v = kernel( ivec3( x, y, z ) );
+        if( k==0 ){ res.x = v; } else if( k==1 ){ res.y = v; }
+        else if( k==2 ){ res.z = v; } else { res.w = v; }
+    }   return res;
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class kernel_t : public gpu_t {
+protected:
+
+    struct SHAPE {
+        ulong x=0, y=1, z=1;
+        map_t<string_t,bool> arrays;
+        string_t source;
+    };  ptr_t<SHAPE> shape;
+
+    void set_kernel_library() {
+        string_t out;
+        for( auto x: shape->arrays.data() ){ out += regex::format( _array_fetch_, x.first ); }
+        /**/ out += regex::format( _array_kernel_, shape->source );
+        set_library( out );
+    }
+
+public:
+
+    kernel_t( string_t kernel ) : gpu_t( _array_main_ ), shape( new SHAPE() ) {
+        shape->source = kernel; set_kernel_library();
+    }
+
+    kernel_t() noexcept : gpu_t(), shape( new SHAPE() ) {}
+
+    /*─······································································─*/
+
+    kernel_t& set_output( ulong x, ulong y=1, ulong z=1 ) {
+        if( x * y * z == 0 ){ throw except_t( "invalid output shape" ); }
+        uint w, h; flat_t::get_layout( x * y * z, w, h );
+        shape->x = x; shape->y = y; shape->z = z;
+
+        gpu_t::set_output( w, h, OUT_DOUBLE4 );
+        gpu_t::set_input ( ivec3_t({ (int) x, (int) y, (int) z }), "shape" );
+        gpu_t::set_input ( (int) w, "gpu_width" ); return *this;
+    }
+
+    template< class T >
+    kernel_t& set_input( const T& value, string_t name ) {
+        gpu_t::set_input( value, name ); return *this;
+    }
+
+    kernel_t& set_input( const flat_t& value, string_t name ) {
+        auto mat = value.get();
+
+        gpu_t::set_input( mat, name );
+        gpu_t::set_input( ivec3_t({ (int) value.x(), (int) value.y(), (int) value.z() }), name + "_shape" );
+        gpu_t::set_input( vec2_t ({ (float) mat.width(), (float) mat.height() }), name + "_size" );
+
+        if( !shape->arrays.has( name ) ){ shape->arrays[ name ] = true; set_kernel_library(); }
+        return *this;
+    }
+
+    /*─······································································─*/
+
+    flat_t operator()() {
+        return flat_t( gpu_t::operator()(), shape->x, shape->y, shape->z );
+    }
+
+    promise_t<flat_t,except_t> run_async() {
+        auto task = gpu_t::run_async(); auto self = shape;
+    return promise_t<flat_t,except_t>([=](
+        function_t<void,flat_t> res, function_t<void,except_t> rej
+    ){  auto item = task;
+        item.then([=]( matrix_t out ){ res( flat_t( out, self->x, self->y, self->z ) ); });
+        item.fail([=]( except_t err ){ rej( err ); });
+    }); }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
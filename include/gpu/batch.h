@@ -0,0 +1,276 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_BATCH
+#define NODEPP_GPU_BATCH
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_BATCH_JOBS
+#define GPU_BATCH_JOBS 1024 // jobs packed into a single atlas
+#endif
+
+#ifndef GPU_BATCH_WIDTH
+#define GPU_BATCH_WIDTH 1024 // atlas shelf width unless a job is wider
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* every job is one rectangle whose vertex colour carries its index; row 0
+   of gpu_batch_jobs holds the output rects, row k+1 those of input k */
+namespace nodepp { namespace gpu { string_t _batch_library_=GPU_KERNEL(
+    in vec4 fragColor;
+    int  gpu_batch_id(){ vec3 c = floor( fragColor.rgb * 255.0 + 0.5 ); return int( c.r + c.g * 256.0 + c.b * 65536.0 ); }
+    vec4 gpu_batch_rect( int slot ){ return texelFetch( gpu_batch_jobs, ivec2( gpu_batch_id(), slot ), 0 ); }
+);}}
+
+/* job-local coordinates mapped into the atlas, clamped to the job's edge */
+namespace nodepp { namespace gpu { string_t _batch_input_=GPU_KERNEL(
+    vec2 gpu_batch_${0}( vec2 c ){
+        vec4 r = gpu_batch_rect( ${1} ); c = clamp( c, 0.5 / r.zw, 1.0 - 0.5 / r.zw );
+        return ( r.xy + c * r.zw ) / vec2( textureSize( ${0}, 0 ) );
+    }
+    ivec2 gpu_batch_fetch_${0}( ivec2 p ){
+        vec4 r = gpu_batch_rect( ${1} ); return ivec2( r.xy ) + clamp( p, ivec2( 0 ), ivec2( r.zw ) - 1 );
+    }
+    ivec2 gpu_batch_size_${0}(){ return ivec2( gpu_batch_rect( ${1} ).zw ); }
+);}}
+
+/* the kernel's own texture(), texelFetch() and textureSize() calls on an
+   atlas sampler are redirected to these */
+namespace nodepp { namespace gpu { string_t _batch_calls_=GPU_KERNEL(
+    vec4  gpu_batch_texture_${0}( vec2 c ){ return texture( ${0}, gpu_batch_${0}( c ) ); }
+    vec4  gpu_batch_texelFetch_${0}( ivec2 p, int l ){ return texelFetch( ${0}, gpu_batch_fetch_${0}( p ), l ); }
+    ivec2 gpu_batch_textureSize_${0}( int l ){ return gpu_batch_size_${0}(); }
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class batch_t {
+protected:
+
+    struct JOB {
+        uint width=0, height=0; map_t<string_t,matrix_t> inputs;
+        matrix_t result; except_t error; int state=0;
+    };
+
+    struct RECT { uint x, y, w, h; };
+
+    struct NODE {
+        array_t<ptr_t<JOB>> queue;
+        gpu_t kernel; string_t library;
+        uint format=OUT_DOUBLE4;
+        bool scheduled=0, state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    /* shelf packing in submission order; false once the atlas outgrows
+       the max texture size */
+    static bool pack( const array_t<RECT>& size, array_t<RECT>& out, uint& width, uint& height ) {
+        uint max = get_max_texture_size(); width = GPU_BATCH_WIDTH; height = 0;
+        for( auto& x: size ){ if( x.w>width ){ width = x.w; } } if( width>max ){ return false; }
+
+        uint x=0, y=0, shelf=0; out.clear(); for( auto& item: size ){
+             if( x + item.w > width ){ x = 0; y += shelf; shelf = 0; }
+             out.push( RECT({ x, y, item.w, item.h }) ); x += item.w;
+             if( item.h > shelf ){ shelf = item.h; }
+        }    height = y + shelf; return height<=max;
+    }
+
+    static string_t get_key( const ptr_t<JOB>& job ) noexcept {
+        string_t out; for( auto x: job->inputs.data() ){
+             out += x.first + ":" + string::to_string( x.second.format() ) + ";";
+        }    return out;
+    }
+
+    /*─······································································─*/
+
+    /* no GL context: every job runs alone through the kernel's CPU fallback */
+    void run_fallback( array_t<ptr_t<JOB>>& jobs ) const {
+        for( auto& job: jobs ){ try {
+             auto& kernel = obj->kernel; kernel.set_output( job->width, job->height, obj->format );
+             for( auto x: job->inputs.data() ){ kernel.set_input( x.second, x.first ); }
+             job->result = kernel(); job->state = 1;
+        } catch( except_t err ){ job->error = err; job->state = -1; } }
+    }
+
+    /* one upload per input atlas, one draw call and one readback for every job */
+    void run_atlas( array_t<ptr_t<JOB>>& jobs ) const {
+        auto& kernel = obj->kernel; auto& names = jobs[0]->inputs;
+        ulong n = jobs.size(), k = 0; uint aw=0, ah=0;
+
+        array_t<string_t> stale; for( auto x: kernel.obj->vars.data() ){ // atlases of another group
+             if( x.second.type>=0x50 && x.first!="gpu_batch_jobs" && !names.has( x.first ) ){ stale.push( x.first ); }
+        }    for( auto& x: stale ){ kernel.remove_input( x ); }
+
+        array_t<RECT> size, rect; for( auto& job: jobs ){
+             size.push( RECT({ 0, 0, job->width, job->height }) );
+        }    if( !pack( size, rect, aw, ah ) ){ throw except_t("batch exceeds the max texture size"); }
+
+        matrix_t table( n, names.size()+1, OUT_DOUBLE4 ); float* cell = (float*) &table.raw();
+        auto set_rect = [&]( ulong slot, ulong job, const RECT& r ){
+             float* x = cell + ( slot * n + job ) * 4;
+             x[0] = r.x; x[1] = r.y; x[2] = r.w; x[3] = r.h;
+        };   for( ulong x=0; x<n; ++x ){ set_rect( 0, x, rect[x] ); }
+
+        string_t library = _batch_library_; array_t<gpu_t::CALL> calls;
+        for( auto name: names.data() ){ ++k;
+             array_t<RECT> in, place; uint iw=0, ih=0;
+             for( auto& job: jobs ){ auto m = job->inputs[ name.first ]; in.push( RECT({ 0, 0, m.width(), m.height() }) ); }
+             if( !pack( in, place, iw, ih ) ){ throw except_t("batch exceeds the max texture size"); }
+
+             matrix_t atlas( iw, ih, name.second.format() ); for( ulong x=0; x<n; ++x ){
+                  auto m = jobs[x]->inputs[ name.first ]; set_rect( k, x, place[x] );
+                  atlas.paste( m, place[x].x, place[x].y, m.width(), m.height() );
+             }
+
+             kernel.set_input( atlas, name.first );
+             library += regex::format( _batch_input_, name.first, string::to_string( k ) );
+             library += regex::format( _batch_calls_, name.first );
+             for( string_t fn: { "texture", "texelFetch", "textureSize" } )
+                { calls.push( gpu_t::CALL({ fn, name.first, "gpu_batch_" + fn + "_" + name.first }) ); }
+        }
+
+        kernel.set_input( table, "gpu_batch_jobs" ).set_library( obj->library );
+        if( kernel.obj->wrappers!=library ){ kernel.obj->shader = ptr_t<RL::Shader>(); }
+        kernel.obj->wrappers = library; kernel.obj->calls = calls;
+        string_t prelude = "uv = gl_FragCoord.xy - gpu_batch_rect( 0 ).xy;";
+        if( kernel.obj->prelude!=prelude ){ kernel.obj->prelude = prelude; kernel.obj->shader = ptr_t<RL::Shader>(); }
+        if( kernel.is_stale() ){ kernel.compile(); }
+
+        auto target = pool::get_target( aw, ah, obj->format ); matrix_t out;
+        try {
+            stats::scope_t scope( &kernel.obj->stats ); stats::add_dispatch();
+            RL::rlDrawRenderBatchActive(); RL::BeginTextureMode( target );
+            RL::ClearBackground( RL::BLACK ); RL::BeginShaderMode( *kernel.obj->shader );
+            kernel.set_kernel_variables();
+
+            for( ulong x=0; x<n; ++x ){ auto& r = rect[x]; // GL rows count from the bottom
+                 RL::Color id = { (uchar)( x & 0xff ), (uchar)( ( x >> 8 ) & 0xff ), (uchar)( ( x >> 16 ) & 0xff ), 255 };
+                 RL::DrawRectangle( r.x, ah - r.y - r.h, r.w, r.h, id );
+            }    RL::EndShaderMode(); RL::EndTextureMode();
+
+            out = matrix_t( target.texture );
+        } catch( except_t err ) { pool::put_target( target ); throw err; }
+        /*-------------------*/ { pool::put_target( target ); }
+
+        for( ulong x=0; x<n; ++x ){ auto& r = rect[x];
+             jobs[x]->result = out.slice( r.x, r.y, r.w, r.h ); jobs[x]->state = 1;
+        }
+    }
+
+    /*─······································································─*/
+
+    /* drains the queue in groups that share one set of input names and
+       formats, at most GPU_BATCH_JOBS at a time */
+    void flush_queue() const {
+        obj->scheduled = 0; while( !obj->queue.empty() ){
+            auto key = get_key( obj->queue[0] ); array_t<ptr_t<JOB>> jobs, rest;
+
+            for( auto& job: obj->queue ){
+                 if( jobs.size()<GPU_BATCH_JOBS && get_key( job )==key ){ jobs.push( job ); }
+                 else { rest.push( job ); }
+            }    obj->queue = rest;
+
+            try { if( _gpu_ ){ run_atlas( jobs ); } else { run_fallback( jobs ); } }
+            catch( except_t err ){ for( auto& job: jobs ){
+            if   ( job->state==0 ){ job->error = err; job->state = -1; } } }
+        }
+    }
+
+public:
+
+    batch_t( string_t kernel, uint format=OUT_DOUBLE4 ) : obj( new NODE() ) {
+        if( get_channels( format )==0 ){ throw except_t("invalid batch format"); }
+        obj->kernel = gpu_t( kernel ); obj->format = format;
+    }
+
+    batch_t() noexcept : obj( new NODE() ){ obj->state = 0; }
+    virtual ~batch_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    void free() const noexcept { if( !is_closed() ){
+        for( auto& job: obj->queue ){ job->error = except_t("gpu batch closed"); job->state = -1; }
+        obj->queue.clear(); obj->kernel.free(); obj->state = 0;
+    }}
+
+    /*─······································································─*/
+
+    /* shared by every job of the batch; samplers travel with each job */
+    template< class T >
+    batch_t& set_input( const T& value, string_t name ) {
+        if( gpu_type_id<T>::value >= 0x50 ){ throw except_t("batch samplers are passed per job"); }
+        obj->kernel.set_input( value, name ); return *this;
+    }
+
+    template< class T >
+    batch_t& set_constant( string_t name, const T& value ) {
+        obj->kernel.set_constant( name, value ); return *this;
+    }
+
+    batch_t& set_library( string_t source ) noexcept { obj->library = source; return *this; }
+
+    batch_t& set_fallback( function_t<matrix_t,gpu_t&> cb ) noexcept {
+        obj->kernel.set_fallback( cb ); return *this;
+    }
+
+    batch_t& set_name( string_t name ) { obj->kernel.set_name( name ); return *this; }
+
+    stats_t get_stats() const noexcept { return obj->kernel.get_stats(); }
+
+    ulong size() const noexcept { return obj->queue.size(); }
+
+    /*─······································································─*/
+
+    /* queues a width x height job; everything queued in the same event-loop
+       turn is flushed together on the next one */
+    promise_t<matrix_t,except_t> add( uint width, uint height, map_t<string_t,matrix_t> inputs ) {
+        if( is_closed() ){ throw except_t("gpu batch closed"); }
+        if( width==0 || height==0 ){ throw except_t("invalid batch job size"); }
+        for( auto x: inputs.data() ){ if( x.first=="gpu_batch_jobs" ){ throw except_t("invalid variable name"); } }
+
+        auto job = ptr_t<JOB>( new JOB() ); job->width = width; job->height = height;
+        job->inputs = inputs; obj->queue.push( job ); batch_t self = *this;
+
+        if( !obj->scheduled ){ obj->scheduled = 1;
+            process::add([=](){ if( !self.is_closed() ){ self.flush_queue(); } return -1; });
+        }
+
+    return promise_t<matrix_t,except_t>([=](
+        function_t<void,matrix_t> res, function_t<void,except_t> rej
+    ){ process::add([=](){
+        if( job->state==0 ){ return 1; }
+        if( job->state>0 ){ res( job->result ); } else { rej( job->error ); }
+    return -1; }); }); }
+
+    /* single-sampler job whose output matches the input size */
+    promise_t<matrix_t,except_t> add( const matrix_t& input, string_t name ) {
+        map_t<string_t,matrix_t> inputs; inputs[ name ] = input;
+        return add( input.width(), input.height(), inputs );
+    }
+
+    /* runs everything queued right now instead of waiting for the next turn */
+    batch_t& flush() { if( is_closed() ){ throw except_t("gpu batch closed"); } flush_queue(); return *this; }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_COMPUTE
+#define NODEPP_GPU_COMPUTE
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* ${0} version ${1..3} local size ${4} constants ${5} buffers ${6} uniforms
+   ${7} shared ${8} library ${9} source */
+namespace nodepp { namespace gpu { string_t _compute_=GPU_KERNEL(
+    ${0} layout( local_size_x=${1}, local_size_y=${2}, local_size_z=${3} ) in;
+    ${4} ${5} ${6} ${7} ${8} void main(){ ${9} }
+);}}
+
+namespace nodepp { namespace gpu { string_t _compute_buffer_=GPU_KERNEL(
+    layout( std430, binding=${0} ) ${1} buffer gpu_${2}_t { ${3} ${2}[]; };
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace compute {
+
+    /* GL 4.3 context with glDispatchCompute resolved; Mesa llvmpipe qualifies */
+    bool has_compute() noexcept {
+        static int out = -1; if( out>=0 ){ return out==1; }
+        if( !_gpu_ ){ return false; } auto gl = RL::GL::Load(); int major=0, minor=0;
+        gl->GetIntegerv( RL::GL::MAJOR_VERSION, &major );
+        gl->GetIntegerv( RL::GL::MINOR_VERSION, &minor );
+        out = ( major>4 || ( major==4 && minor>=3 ) ) && gl->DispatchCompute!=nullptr
+           && gl->MemoryBarrier!=nullptr && gl->GetBufferSubData!=nullptr;
+        return out==1;
+    }
+
+    uint get_max_invocations() noexcept {
+        static int out = 0; if( out>0 ){ return out; }
+        RL::GL::Load()->GetIntegerv( RL::GL::MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &out );
+        if( out<=0 ){ out = 128; } return out; // GL 4.3 minimum
+    }
+
+    /* linked through the FN table: raylib only builds its compute helpers
+       for GRAPHICS_API_OPENGL_43, programs still live in gpu::cache */
+    ptr_t<RL::Shader> get_program( string_t code ) {
+        auto key = cache::hash( code ); string_t path;
+        if( cache::_programs_.has( key ) ){ return cache::_programs_[ key ]; }
+
+        if( !cache::_path_.empty() && cache::has_binary_support() ){
+            path = regex::format( "${0}/${1}.bin", cache::_path_, cache::hash( code + cache::get_driver() ) );
+            auto out = cache::load_binary( path );
+            if( !out.null() ){ cache::_programs_[ key ] = out; return out; }
+        }
+
+        auto gl = RL::GL::Load(); int status = 0;
+        uint shader = RL::rlCompileShader( code.get(), RL::GL::COMPUTE_SHADER );
+        if( shader==0 ){ throw except_t("Invalid Compute Shader"); }
+
+        uint id = gl->CreateProgram(); gl->AttachShader( id, shader );
+        gl->LinkProgram( id ); gl->DeleteShader( shader );
+        gl->GetProgramiv( id, RL::GL::LINK_STATUS, &status );
+        if( status==0 ){ gl->DeleteProgram( id ); throw except_t("Invalid Compute Shader"); }
+
+        auto out = type::bind( cache::get_shader( id ) );
+        if( !path.empty() ){ cache::save_binary( path, *out ); }
+        cache::_programs_[ key ] = out; return out;
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class compute_t {
+protected:
+
+    /* one SSBO per matrix: vec4 elements for 4-channel formats, otherwise
+       floats with the channel count as stride, bound in registration order */
+    struct BUFFER { string_t name; uint id=0; ulong size=0; uint channels=4; };
+    struct SLOT   { int loc=-2; }; // -2 until looked up in the linked program
+    struct DONE   { any_t value; uchar type; ptr_t<SLOT> slot; };
+
+    struct NODE {
+        array_t<BUFFER> buffers;
+        array_t<string_t> shared;
+        map_t<string_t,DONE> /*-----*/ vars;
+        map_t<string_t,string_t> constants;
+        ptr_t<RL::Shader> /*-----*/ shader;
+        ptr_t<stats_t> stats=ptr_t<stats_t>( new stats_t() );
+        string_t /*--------*/ kernel, library;
+        uint local[3] = { 64, 1, 1 }; /*-----*/
+        uint width=0, height=0, format=OUT_DOUBLE4;
+        int  /*--------------*/ size_loc=-2;
+        ulong /*-----------*/ generation=0;
+        bool /*-----------------*/ state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    static void check_name( const string_t& name ) {
+        if( name.empty() )
+          { throw except_t("invalid variable name"); }
+        if( regex::test( name, "^[ 0-9]+", true ) || regex::test( name, "[^a-z0-9_]+", true ) )
+          { throw except_t("invalid variable name"); }
+    }
+
+    BUFFER& get_buffer( const string_t& name ) {
+        for( auto& x: obj->buffers ){ if( x.name==name ){ return x; } }
+        BUFFER item; item.name = name; obj->buffers.push( item );
+        obj->shader = ptr_t<RL::Shader>(); return obj->buffers[ obj->buffers.size()-1 ];
+    }
+
+    void set_buffer( BUFFER& item, ulong size, const void* data ) {
+        auto gl = RL::GL::Load(); auto time = stats::now();
+        if( item.id==0 ){ gl->GenBuffers( 1, &item.id ); }
+        gl->BindBuffer( RL::GL::SHADER_STORAGE_BUFFER, item.id );
+        if( item.size!=size ){ gl->BufferData( RL::GL::SHADER_STORAGE_BUFFER, size, data, RL::GL::DYNAMIC_COPY ); }
+        else if( data!=nullptr ){ gl->BufferSubData( RL::GL::SHADER_STORAGE_BUFFER, 0, size, data ); }
+        gl->BindBuffer( RL::GL::SHADER_STORAGE_BUFFER, 0 ); item.size = size;
+        if( data!=nullptr ){ stats::add_upload( stats::now() - time, size ); }
+    }
+
+    /*─······································································─*/
+
+    string_t get_buffers() const noexcept {
+        string_t out; ulong n = 0; for( auto& x: obj->buffers ){
+             out += regex::format( _compute_buffer_, string::to_string( n++ ),
+                    x.name=="gpu_output" ? "" : "readonly",
+                    x.name, x.channels==4 ? "vec4" : "float" );
+        }    return out;
+    }
+
+    string_t get_uniforms() const noexcept {
+        string_t out = "uniform ivec2 gpu_size;\n"; for( auto x: obj->vars.data() ){
+             auto type = get_uniform_type( x.second.type ); if( type==nullptr ){ continue; }
+             out += regex::format( "uniform ${0} ${1};\n", type, x.first );
+        }    return out;
+    }
+
+    string_t get_constants() const noexcept {
+        string_t out; for( auto x: obj->constants.data() ){
+             out += regex::format( "\n#define ${0} ${1}\n", x.first, x.second );
+        }    return out;
+    }
+
+    string_t get_shared() const noexcept {
+        string_t out; for( auto& x: obj->shared ){ out += "shared " + x + ";\n"; }
+        return out;
+    }
+
+    /*─······································································─*/
+
+    /* looked up once per linked program, compile() resets them */
+    int get_location( const char* name, int& loc ) const noexcept {
+        if( loc==-2 ){ loc = RL::rlGetLocationUniform( obj->shader->id, name ); } return loc;
+    }
+
+    void reset_locations() const noexcept {
+        obj->size_loc = -2; for( auto x: obj->vars.data() ){ x.second.slot->loc = -2; }
+    }
+
+    /* programs linked before a cache::clear() have been unloaded */
+    bool is_stale() const noexcept {
+        return obj->shader.null() || obj->generation!=cache::_generation_;
+    }
+
+    void set_uniforms() const {
+        int size[2] = { (int) obj->width, (int) obj->height };
+        if( get_location( "gpu_size", obj->size_loc )>=0 )
+          { RL::rlSetUniform( obj->size_loc, size, VAR_IVEC2, 1 ); }
+
+    for( auto x: obj->vars.data() ){ auto& y = x.second; const void* data=nullptr; ulong size=0;
+         if( get_location( x.first.get(), y.slot->loc )<0 ){ continue; }
+         auto flag = get_uniform( y.type, y.value, data, size ); if( flag<0 ){ continue; }
+         RL::rlSetUniform( y.slot->loc, data, flag, 1 );
+    }}
+
+public:
+
+    compute_t( string_t kernel ) : obj( new NODE() ){ obj->kernel = kernel; }
+    compute_t() noexcept : obj( new NODE() ){ obj->state = 0; }
+    virtual ~compute_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    void free() const noexcept { if( !is_closed() ){
+        if( _gpu_ ){ auto gl = RL::GL::Load(); for( auto& x: obj->buffers ){
+        if( x.id!=0 ){ gl->DeleteBuffers( 1, &x.id ); x.id = 0; } }}
+        /**/ obj->state = 0; /*--------------------------------------*/
+    }}
+
+    /*─······································································─*/
+
+    /* workgroup shape, gl_WorkGroupSize in the kernel */
+    compute_t& set_local_size( uint x, uint y=1, uint z=1 ) {
+        if( x*y*z==0 ){ throw except_t("invalid local size"); }
+        if( _gpu_ && x*y*z > compute::get_max_invocations() )
+          { throw except_t( "local size exceeds", compute::get_max_invocations() ); }
+        if( obj->local[0]==x && obj->local[1]==y && obj->local[2]==z ){ return *this; }
+        obj->local[0] = x; obj->local[1] = y; obj->local[2] = z;
+        obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    /* workgroup-local storage, e.g. "vec4 tile[64]" becomes `shared vec4 tile[64];` */
+    compute_t& add_shared( string_t declaration ) {
+        if( declaration.empty() ){ throw except_t("invalid shared declaration"); }
+        obj->shared.push( declaration ); obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    compute_t& set_library( string_t source ) noexcept {
+        if( obj->library==source ){ return *this; }
+        obj->library = source; obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    compute_t& set_constant( string_t name, string_t value ) {
+        check_name( name ); if( obj->constants.has( name ) && obj->constants[ name ]==value ){ return *this; }
+        obj->constants[ name ] = value; obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    compute_t& set_constant( string_t name, int value ){ return set_constant( name, string::to_string( value ) ); }
+
+    compute_t& set_name( string_t name ) {
+        if( name.empty() ){ throw except_t("invalid kernel name"); }
+        stats::_registry_[ name ] = obj->stats; return *this;
+    }
+
+    stats_t get_stats() const noexcept { return *obj->stats; }
+
+    /*─······································································─*/
+
+    /* gpu_output[]: width x height texels of an OUT_DOUBLE* format */
+    compute_t& set_output( uint width, uint height, uint format=OUT_DOUBLE4 ) {
+        if( get_depth( format )!=sizeof(float) ){ throw except_t("compute outputs must be OUT_DOUBLE*"); }
+        if( !compute::has_compute() ){ throw except_t("compute shaders need a GL 4.3 context"); }
+
+        auto& item = get_buffer( "gpu_output" ); uint channels = get_channels( format );
+        if( item.channels!=channels ){ item.channels = channels; obj->shader = ptr_t<RL::Shader>(); }
+        obj->width = width; obj->height = height; obj->format = format;
+        set_buffer( item, (ulong) width * height * channels * sizeof(float), nullptr );
+        return *this;
+    }
+
+    /* uploaded right away as a readonly SSBO; call again after editing the matrix */
+    compute_t& set_input( const matrix_t& value, string_t name ) {
+        check_name( name ); if( name=="gpu_output" ){ throw except_t("invalid variable name"); }
+        if( !compute::has_compute() ){ throw except_t("compute shaders need a GL 4.3 context"); }
+        if( obj->vars.has( name ) ){ throw except_t("variable already used as a uniform"); }
+
+        auto& item = get_buffer( name ); uint channels = value.channels()==4 ? 4 : 1;
+        if( item.channels!=channels ){ item.channels = channels; obj->shader = ptr_t<RL::Shader>(); }
+
+        if( value.format()==OUT_DOUBLE4 || value.format()==OUT_DOUBLE ){
+            ulong size = (ulong) value.width() * value.height() * value.channels() * sizeof(float);
+            set_buffer( item, size, value.get_image().data );
+        } else { auto data = value.to_float(); set_buffer( item, data.size() * sizeof(float), &data ); }
+
+        return *this;
+    }
+
+    template< class T >
+    compute_t& set_input( const T& value, string_t name ) {
+        if( gpu_type_id<T>::value == 0xff || gpu_type_id<T>::value >= 0x50 )
+          { throw except_t("invalid gpu object type"); }
+        check_name( name ); for( auto& x: obj->buffers ){
+        if( x.name==name ){ throw except_t("variable already used as a buffer"); } }
+
+        DONE item; item.type = gpu_type_id<T>::value; item.value = type::bind( value );
+        if( obj->vars.has( name ) && obj->vars[ name ].type==item.type )
+             { item.slot = obj->vars[ name ].slot; }
+        else { item.slot = ptr_t<SLOT>( new SLOT() ); obj->shader = ptr_t<RL::Shader>(); }
+        obj->vars[ name ] = item; return *this;
+    }
+
+    compute_t& remove_input( string_t name ) {
+        if( obj->vars.has( name ) ){ obj->vars.erase( name ); obj->shader = ptr_t<RL::Shader>(); return *this; }
+        for( ulong x=0; x<obj->buffers.size(); ++x ){ auto& item = obj->buffers[x];
+        if ( item.name!=name || name=="gpu_output" ){ continue; }
+        if ( item.id!=0 && _gpu_ ){ RL::GL::Load()->DeleteBuffers( 1, &item.id ); }
+             array_t<BUFFER> list; for( ulong y=0; y<obj->buffers.size(); ++y ){
+             if( y!=x ){ list.push( obj->buffers[y] ); } }
+             obj->buffers = list; obj->shader = ptr_t<RL::Shader>(); break;
+        }    return *this;
+    }
+
+    /*─······································································─*/
+
+    compute_t& compile() {
+        if( obj->kernel.empty() ){ throw except_t("no kernel found"); }
+        if( !compute::has_compute() ){ throw except_t("compute shaders need a GL 4.3 context"); }
+        stats::scope_t scope( &obj->stats ); auto time = stats::now();
+
+        obj->shader = compute::get_program( regex::format( _compute_, "#version 430\n",
+            string::to_string( obj->local[0] ), string::to_string( obj->local[1] ),
+            string::to_string( obj->local[2] ), get_constants(), get_buffers(),
+            get_uniforms(), get_shared(), obj->library, obj->kernel
+        )); reset_locations(); obj->generation = cache::_generation_;
+
+        stats::add_compile( stats::now() - time ); return *this;
+    }
+
+    /* groups x, y, z of local_size invocations each, followed by a storage barrier */
+    compute_t& dispatch( uint x, uint y=1, uint z=1 ) { if( !is_closed() ){
+        if( is_stale() ){ compile(); } auto gl = RL::GL::Load();
+        stats::scope_t scope( &obj->stats ); auto time = stats::now();
+
+        RL::rlDrawRenderBatchActive(); RL::rlEnableShader( obj->shader->id ); set_uniforms();
+        for( ulong n=0; n<obj->buffers.size(); ++n ){
+             gl->BindBufferBase( RL::GL::SHADER_STORAGE_BUFFER, n, obj->buffers[n].id );
+        }
+
+        gl->DispatchCompute( x, y, z );
+        gl->MemoryBarrier( RL::GL::SHADER_STORAGE_BARRIER_BIT | RL::GL::BUFFER_UPDATE_BARRIER_BIT );
+        RL::rlDisableShader();
+
+        stats::add_dispatch(); stats::add_draw( stats::now() - time ); return *this;
+    } throw except_t( "compute kernel closed" ); }
+
+    /*─······································································─*/
+
+    matrix_t get() const {
+        if( obj->width==0 || obj->height==0 ){ throw except_t("invalid compute output"); }
+        auto gl = RL::GL::Load(); auto time = stats::now();
+        ptr_t<uchar> data( (ulong) obj->width * obj->height * get_channels( obj->format ) * sizeof(float), 0x00 );
+
+        for( auto& x: obj->buffers ){ if( x.name!="gpu_output" ){ continue; }
+             gl->BindBuffer( RL::GL::SHADER_STORAGE_BUFFER, x.id );
+             gl->GetBufferSubData( RL::GL::SHADER_STORAGE_BUFFER, 0, data.size(), &data );
+             gl->BindBuffer( RL::GL::SHADER_STORAGE_BUFFER, 0 );
+        }
+
+        stats::add_readback( stats::now() - time, data.size() );
+        return matrix_t( obj->width, obj->height, data, obj->format );
+    }
+
+    /* one invocation per output texel, rounded up to whole workgroups */
+    matrix_t operator()() {
+        if( obj->width==0 || obj->height==0 ){ throw except_t("invalid compute output"); }
+        stats::scope_t scope( &obj->stats );
+        dispatch( ( obj->width  + obj->local[0] - 1 ) / obj->local[0],
+                  ( obj->height + obj->local[1] - 1 ) / obj->local[1] );
+        return get();
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_CONV
+#define NODEPP_GPU_CONV
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "cpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_CONV_DIRECT
+#define GPU_CONV_DIRECT 121 // largest non-separable filter (taps) run directly
+#endif
+
+namespace nodepp { namespace gpu { enum CONV_MODE {
+    CONV_AUTO      = 0b00000000,
+    CONV_DIRECT    = 0b00000001,
+    CONV_SEPARABLE = 0b00000010,
+    CONV_FFT       = 0b00000100
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { string_t _conv_direct_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); ivec2 m = textureSize( src, 0 ) - 1; vec4 acc = vec4( 0.0 );
+    ${0} return acc;
+);}}
+
+namespace nodepp { namespace gpu { string_t _conv_tap_=GPU_KERNEL(
+    acc += ${0} * texelFetch( src, clamp( p + ivec2( ${1}, ${2} ), ivec2( 0 ), m ), 0 );
+);}}
+
+/* two complex signals per texel: ( r + ig ) in xy and ( b + ia ) in zw */
+namespace nodepp { namespace gpu { string_t _conv_pad_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); ivec2 s = textureSize( src, 0 );
+    ivec2 h = s + ( ivec2( PAD_W, PAD_H ) - s ) / 2;
+    ivec2 q = ivec2( p.x < s.x ? p.x : p.x < h.x ? s.x - 1 : 0,
+                     p.y < s.y ? p.y : p.y < h.y ? s.y - 1 : 0 );
+    return texelFetch( src, q, 0 );
+);}}
+
+/* flipped and centred on the origin so the product matches the direct
+   (correlation) path tap for tap */
+namespace nodepp { namespace gpu { string_t _conv_filter_=GPU_KERNEL(
+    ivec2 p = ivec2( uv );
+    int j = CX - p.x; j = j < 0 ? j + PAD_W : j;
+    int i = CY - p.y; i = i < 0 ? i + PAD_H : i;
+    if( j>=KW || i>=KH ){ return vec4( 0.0 ); }
+    return vec4( texelFetch( weights, ivec2( j, i ), 0 ).x, 0.0, 0.0, 0.0 );
+);}}
+
+/* one radix-2 Stockham stage in gather form, NS is the half butterfly span */
+namespace nodepp { namespace gpu { string_t _conv_fft_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); int i = AXIS==0 ? p.x : p.y;
+    int m = i % ( 2 * NS ); int k = m % NS; int j = ( i / ( 2 * NS ) ) * NS + k;
+    vec4 a = texelFetch( src, AXIS==0 ? ivec2( j, p.y ) : ivec2( p.x, j ), 0 );
+    vec4 b = texelFetch( src, AXIS==0 ? ivec2( j + N / 2, p.y ) : ivec2( p.x, j + N / 2 ), 0 );
+    float t = SIGN * 6.28318530718 * float( k ) / float( 2 * NS ); vec2 w = vec2( cos( t ), sin( t ) );
+    vec4  v = vec4( b.x*w.x - b.y*w.y, b.x*w.y + b.y*w.x, b.z*w.x - b.w*w.y, b.z*w.y + b.w*w.x );
+    return m < NS ? a + v : a - v;
+);}}
+
+namespace nodepp { namespace gpu { string_t _conv_mul_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); vec4 a = texelFetch( src, p, 0 ); vec2 h = texelFetch( spectrum, p, 0 ).xy;
+    return vec4( a.x*h.x - a.y*h.y, a.x*h.y + a.y*h.x, a.z*h.x - a.w*h.y, a.z*h.y + a.w*h.x );
+);}}
+
+namespace nodepp { namespace gpu { string_t _conv_crop_=GPU_KERNEL(
+    return texelFetch( src, ivec2( uv ), 0 ) * SCALE;
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace cpu {
+
+    /* the direct path tap for tap: correlation with clamp-to-edge borders,
+       zero weights skipped; every CONV_MODE lands here without a context */
+    matrix_t convolve( const matrix_t& input, uint kw, uint kh, const ptr_t<float>& weights, uint format ) {
+        int w = input.width(), h = input.height(), cx = kw / 2, cy = kh / 2; uint fmt = input.format();
+        const uchar* src = &input.raw(); const float* taps = &weights;
+        matrix_t out( w, h, format ); uchar* dst = &out.raw();
+
+        parallel_for( (ulong) w * h, [&]( ulong begin, ulong end ){ for( ulong i=begin; i<end; ++i ){
+            int px = i % w, py = i / w; texel_t acc;
+            for( int y=0; y<(int) kh; ++y ){ int sy = py + y - cy; sy = sy < 0 ? 0 : sy >= h ? h-1 : sy;
+            for( int x=0; x<(int) kw; ++x ){ float t = taps[ y * kw + x ]; if( t==0 ){ continue; }
+                 int sx = px + x - cx; sx = sx < 0 ? 0 : sx >= w ? w-1 : sx;
+                 acc += t * load( src, (ulong) sy * w + sx, fmt );
+            }}   store( dst, i, format, acc );
+        }}, 1 + GPU_CPU_GRAIN / ( (ulong) kw * kh ) );
+
+        return out;
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace conv {
+
+    string_t get_literal( float value ) noexcept {
+        char buff[32]; snprintf( buff, 32, "%.9g", value ); string_t out = buff;
+        if( !regex::test( out, "[.en]" ) ){ out += ".0"; } return out;
+    }
+
+    uint get_pow2( uint value ) noexcept {
+        uint out = 1; while( out < value ){ out <<= 1; } return out;
+    }
+
+    /* rank-1 test: every tap must equal col[y] * row[x] within tolerance */
+    bool is_separable( uint kw, uint kh, const ptr_t<float>& weights, ptr_t<float>& row, ptr_t<float>& col ) {
+        ulong pivot = 0; float peak = 0;
+        for( ulong x=0; x<weights.size(); ++x ){
+        if ( fabs( weights[x] ) > peak ){ peak = fabs( weights[x] ); pivot = x; }
+        }    if( peak==0 ){ return false; }
+
+        ulong py = pivot / kw, px = pivot % kw;
+        row = ptr_t<float>( kw, 0.0f ); col = ptr_t<float>( kh, 0.0f );
+        for( ulong x=0; x<kw; ++x ){ row[x] = weights[ py * kw + x ]; }
+        for( ulong y=0; y<kh; ++y ){ col[y] = weights[ y * kw + px ] / weights[ pivot ]; }
+
+        for( ulong y=0; y<kh; ++y ){ for( ulong x=0; x<kw; ++x ){
+        if ( fabs( weights[ y * kw + x ] - col[y] * row[x] ) > peak * 1e-5f ){ return false; }
+        }}   return true;
+    }
+
+    /*─······································································─*/
+
+    /* every non-zero weight becomes one unrolled literal tap */
+    matrix_t run_direct( const matrix_t& input, uint kw, uint kh, const ptr_t<float>& weights, uint format ) {
+        string_t taps; int cx = kw / 2, cy = kh / 2;
+
+        for( ulong y=0; y<kh; ++y ){ for( ulong x=0; x<kw; ++x ){
+             float w = weights[ y * kw + x ]; if( w==0 ){ continue; }
+             taps += regex::format( _conv_tap_, get_literal( w ),
+                     string::to_string( (int) x - cx ), string::to_string( (int) y - cy ) );
+        }}
+
+        gpu_t kernel( regex::format( _conv_direct_, taps ) ); kernel
+            .set_output( input.width(), input.height(), format )
+            .set_input ( input, "src" );
+
+        return kernel();
+    }
+
+    matrix_t run_separable( const matrix_t& input, const ptr_t<float>& row, const ptr_t<float>& col, uint format ) {
+        string_t rows, cols; int cx = row.size() / 2, cy = col.size() / 2;
+
+        for( ulong x=0; x<row.size(); ++x ){ if( row[x]==0 ){ continue; }
+             rows += regex::format( _conv_tap_, get_literal( row[x] ), string::to_string( (int) x - cx ), "0" );
+        }
+        for( ulong y=0; y<col.size(); ++y ){ if( col[y]==0 ){ continue; }
+             cols += regex::format( _conv_tap_, get_literal( col[y] ), "0", string::to_string( (int) y - cy ) );
+        }
+
+        gpu_t horizontal( regex::format( _conv_direct_, rows ) );
+        gpu_t vertical  ( regex::format( _conv_direct_, cols ) );
+
+        horizontal.set_output( input.width(), input.height(), OUT_DOUBLE4 ).set_input( input, "src" );
+        vertical  .set_output( input.width(), input.height(), format )
+                  .set_input ( horizontal.render(), "src" );
+
+        return vertical();
+    }
+
+    /*─······································································─*/
+
+    RL::Texture2D run_fft( gpu_t& pass, RL::Texture2D input, RL::RenderTexture2D* target, uint pw, uint ph, float sign ) {
+        RL::Texture2D out = input; pass.set_constant( "SIGN", (double) sign );
+        uint flip = target[0].texture.id==input.id ? 1 : 0; // never read and write one target
+
+        for( uint axis=0; axis<2; ++axis ){
+        uint n = axis==0 ? pw : ph; pass.set_constant( "AXIS", (int) axis ).set_constant( "N", (int) n );
+        for( uint ns=1; ns<n; ns<<=1 ){
+             pass.set_constant( "NS", (int) ns ).set_input( out, "src" );
+             out = pass.render( target[ flip ] ); flip ^= 1;
+        }}   return out;
+    }
+
+    /* the FFT works on the linear-convolution size padded to a power of 2 */
+    bool has_fft_room( const matrix_t& input, uint kw, uint kh ) noexcept {
+        uint max = get_max_texture_size();
+        return get_pow2( input.width () + kw - 1 ) <= max
+            && get_pow2( input.height() + kh - 1 ) <= max;
+    }
+
+    matrix_t run_fft( const matrix_t& input, uint kw, uint kh, const ptr_t<float>& weights, uint format ) {
+        uint pw = get_pow2( input.width () + kw - 1 );
+        uint ph = get_pow2( input.height() + kh - 1 );
+        if( !has_fft_room( input, kw, kh ) )
+          { throw except_t( "fft convolution exceeds the max texture size" ); }
+
+        RL::RenderTexture2D image[2] = { pool::get_target( pw, ph, OUT_DOUBLE4 ), pool::get_target( pw, ph, OUT_DOUBLE4 ) };
+        RL::RenderTexture2D fltr [2] = { pool::get_target( pw, ph, OUT_DOUBLE4 ), pool::get_target( pw, ph, OUT_DOUBLE4 ) };
+        matrix_t out;
+
+        try {
+            gpu_t pad( _conv_pad_ ), filter( _conv_filter_ ), mul( _conv_mul_ ), crop( _conv_crop_ ), pass( _conv_fft_ );
+
+            pad.set_constant( "PAD_W", (int) pw ).set_constant( "PAD_H", (int) ph ).set_input( input, "src" );
+            filter.set_constant( "PAD_W", (int) pw ).set_constant( "PAD_H", (int) ph )
+                  .set_constant( "KW", (int) kw ).set_constant( "KH", (int) kh )
+                  .set_constant( "CX", (int) kw / 2 ).set_constant( "CY", (int) kh / 2 )
+                  .set_input   ( matrix_t( kw, kh, ptr_t<uchar>( (uchar*) &weights, kw * kh * sizeof(float) ), OUT_DOUBLE ), "weights" );
+
+            auto spectrum = run_fft( pass, filter.render( fltr [0] ), fltr , pw, ph, -1 );
+            auto signal   = run_fft( pass, pad   .render( image[0] ), image, pw, ph, -1 );
+
+            mul.set_input( signal, "src" ).set_input( spectrum, "spectrum" );
+            signal = run_fft( pass, mul.render( signal.id==image[0].texture.id ? image[1] : image[0] ), image, pw, ph,  1 );
+
+            crop.set_constant( "SCALE", 1.0 / ( (double) pw * ph ) )
+                .set_output  ( input.width(), input.height(), format )
+                .set_input   ( signal, "src" );
+
+            out = crop();
+        } catch( except_t err ) {
+            for( auto& x: image ){ pool::put_target( x ); }
+            for( auto& x: fltr  ){ pool::put_target( x ); } throw err;
+        }   for( auto& x: image ){ pool::put_target( x ); }
+            for( auto& x: fltr  ){ pool::put_target( x ); }
+
+        return out;
+    }
+
+    /*─······································································─*/
+
+    /* kw x kh row-major weights, correlated with clamp-to-edge borders;
+       CONV_AUTO picks separable for rank-1 filters, direct up to
+       GPU_CONV_DIRECT taps and the FFT path above that, unless the padded
+       FFT size would not fit a texture; only explicit CONV_FFT throws then */
+    matrix_t convolve( const matrix_t& input, uint kw, uint kh, ptr_t<float> weights,
+                       uint format=OUT_DOUBLE4, uint mode=CONV_AUTO ) {
+        if( kw * kh == 0 || weights.size()!=(ulong) kw * kh )
+          { throw except_t( "convolution weights size must be", kw * kh ); }
+
+        if( !_gpu_ ){ return cpu::convolve( input, kw, kh, weights, format ); }
+
+        ptr_t<float> row, col; bool separable = false;
+        if( mode==CONV_AUTO || mode==CONV_SEPARABLE )
+          { separable = is_separable( kw, kh, weights, row, col ); }
+
+        if( mode==CONV_SEPARABLE && !separable ){ throw except_t( "filter is not separable" ); }
+        if( separable ){ return run_separable( input, row, col, format ); }
+
+        if( mode==CONV_FFT || ( mode==CONV_AUTO && kw * kh > GPU_CONV_DIRECT
+                                              && has_fft_room( input, kw, kh ) ) )
+          { return run_fft( input, kw, kh, weights, format ); }
+
+        return run_direct( input, kw, kh, weights, format );
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_CPU
+#define NODEPP_GPU_CPU
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if !defined(GPU_CPU_SCALAR) && ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP>=2 ) )
+#include <emmintrin.h>
+#define GPU_CPU_SSE
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_CPU_THREADS
+#define GPU_CPU_THREADS 0 // 0: one per hardware thread, the caller included
+#endif
+
+#ifndef GPU_CPU_GRAIN
+#define GPU_CPU_GRAIN 4096 // texels handed to a worker at a time
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* one RGBA texel, the unit every CPU kernel works on: a single __m128
+   when SSE2 is available, four floats otherwise */
+namespace nodepp { namespace gpu { struct texel_t {
+
+#ifdef GPU_CPU_SSE
+    __m128 v;
+    texel_t( __m128 value ) noexcept : v( value ) {}
+    texel_t() noexcept : v( _mm_setzero_ps() ) {}
+    texel_t( float value ) noexcept : v( _mm_set1_ps( value ) ) {}
+    texel_t( float x, float y, float z, float w ) noexcept : v( _mm_setr_ps( x, y, z, w ) ) {}
+    static texel_t load( const float* ptr ) noexcept { return _mm_loadu_ps( ptr ); }
+    void store( float* ptr ) const noexcept { _mm_storeu_ps( ptr, v ); }
+#else
+    float v[4];
+    texel_t() noexcept { v[0] = v[1] = v[2] = v[3] = 0; }
+    texel_t( float value ) noexcept { v[0] = v[1] = v[2] = v[3] = value; }
+    texel_t( float x, float y, float z, float w ) noexcept { v[0] = x; v[1] = y; v[2] = z; v[3] = w; }
+    static texel_t load( const float* ptr ) noexcept { return texel_t( ptr[0], ptr[1], ptr[2], ptr[3] ); }
+    void store( float* ptr ) const noexcept { memcpy( ptr, v, sizeof(v) ); }
+#endif
+
+    texel_t( const vec4_t& value ) noexcept : texel_t( value.x, value.y, value.z, value.w ) {}
+
+    vec4_t get() const noexcept { float out[4]; store( out ); return vec4_t({ out[0], out[1], out[2], out[3] }); }
+    float operator[]( uint index ) const noexcept { float out[4]; store( out ); return out[ index & 3 ]; }
+
+    float x() const noexcept { return (*this)[0]; }
+    float y() const noexcept { return (*this)[1]; }
+    float z() const noexcept { return (*this)[2]; }
+    float w() const noexcept { return (*this)[3]; }
+
+    /*─······································································─*/
+
+    /* hidden friends: only found through a texel_t argument, so they never
+       hide the <cmath> overloads for the rest of the gpu namespace */
+#ifdef GPU_CPU_SSE
+    friend texel_t operator+( const texel_t& a, const texel_t& b ) noexcept { return _mm_add_ps( a.v, b.v ); }
+    friend texel_t operator-( const texel_t& a, const texel_t& b ) noexcept { return _mm_sub_ps( a.v, b.v ); }
+    friend texel_t operator*( const texel_t& a, const texel_t& b ) noexcept { return _mm_mul_ps( a.v, b.v ); }
+    friend texel_t operator/( const texel_t& a, const texel_t& b ) noexcept { return _mm_div_ps( a.v, b.v ); }
+    friend texel_t min( const texel_t& a, const texel_t& b ) noexcept { return _mm_min_ps( a.v, b.v ); }
+    friend texel_t max( const texel_t& a, const texel_t& b ) noexcept { return _mm_max_ps( a.v, b.v ); }
+    friend texel_t sqrt( const texel_t& a ) noexcept { return _mm_sqrt_ps( a.v ); }
+    friend texel_t abs ( const texel_t& a ) noexcept { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ); }
+#else
+    template< class T >
+    static texel_t get_texel( const texel_t& a, const texel_t& b, T cb ) noexcept {
+        return texel_t( cb( a.v[0], b.v[0] ), cb( a.v[1], b.v[1] ), cb( a.v[2], b.v[2] ), cb( a.v[3], b.v[3] ) );
+    }
+
+    friend texel_t operator+( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return x + y; } ); }
+    friend texel_t operator-( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return x - y; } ); }
+    friend texel_t operator*( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return x * y; } ); }
+    friend texel_t operator/( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return x / y; } ); }
+    friend texel_t min( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return y < x ? y : x; } ); }
+    friend texel_t max( const texel_t& a, const texel_t& b ) noexcept { return get_texel( a, b, []( float x, float y ){ return y > x ? y : x; } ); }
+    friend texel_t sqrt( const texel_t& a ) noexcept { return get_texel( a, a, []( float x, float ){ return ::sqrtf( x ); } ); }
+    friend texel_t abs ( const texel_t& a ) noexcept { return get_texel( a, a, []( float x, float ){ return ::fabsf( x ); } ); }
+#endif
+
+    friend texel_t operator-( const texel_t& a ) noexcept { return texel_t() - a; }
+
+    friend texel_t& operator+=( texel_t& a, const texel_t& b ) noexcept { a = a + b; return a; }
+    friend texel_t& operator-=( texel_t& a, const texel_t& b ) noexcept { a = a - b; return a; }
+    friend texel_t& operator*=( texel_t& a, const texel_t& b ) noexcept { a = a * b; return a; }
+    friend texel_t& operator/=( texel_t& a, const texel_t& b ) noexcept { a = a / b; return a; }
+
+    friend texel_t clamp( const texel_t& a, const texel_t& lo, const texel_t& hi ) noexcept { return min( max( a, lo ), hi ); }
+    friend texel_t mix  ( const texel_t& a, const texel_t& b , const texel_t& t  ) noexcept { return a + ( b - a ) * t; }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace cpu {
+
+    /* texels read the way the GL samplers return them: grayscale as
+       (r,r,r,1), gray-alpha as (r,r,r,a), missing lanes as (0,0,1) */
+    texel_t load( const uchar* data, ulong index, uint format ) noexcept {
+        uint ch = get_channels( format ), dp = get_depth( format );
+        const uchar* ptr = data + index * ch * dp;
+
+        switch( format ){
+            case OUT_DOUBLE4: return texel_t::load( (const float*) ptr );
+        #ifdef GPU_CPU_SSE
+            case OUT_UCHAR4: { int bits; memcpy( &bits, ptr, sizeof(int) ); __m128i zero = _mm_setzero_si128();
+                __m128i v = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( bits ), zero ), zero );
+                return _mm_mul_ps( _mm_cvtepi32_ps( v ), _mm_set1_ps( 1.0f / 255.0f ) );
+            }
+        #endif
+        }
+
+        float out[4] = { 0, 0, 0, 1 }; for( uint x=0; x<ch; ++x ){ switch( dp ){
+            case 1: out[x] = ptr[x] / 255.0f; break;
+            case 2: { ushort h; memcpy( &h, ptr + x*2, 2 ); out[x] = get_half( h ); } break;
+            case 4: memcpy( &out[x], ptr + x*4, 4 ); break;
+        }}
+
+        if  ( format==OUT_UCHAR  ){ out[1] = out[2] = out[0]; }
+        else if( format==OUT_UCHAR2 ){ out[3] = out[1]; out[1] = out[2] = out[0]; }
+        return texel_t::load( out );
+    }
+
+    /* keeps the first `channels` lanes, unsigned formats saturate like a UNORM target */
+    void store( uchar* data, ulong index, uint format, const texel_t& value ) noexcept {
+        uint ch = get_channels( format ), dp = get_depth( format );
+        uchar* ptr = data + index * ch * dp;
+
+        switch( format ){
+            case OUT_DOUBLE4: value.store( (float*) ptr ); return;
+        #ifdef GPU_CPU_SSE
+            case OUT_UCHAR4: {
+                __m128  f = _mm_mul_ps( clamp( value, 0.0f, 1.0f ).v, _mm_set1_ps( 255.0f ) );
+                __m128i v = _mm_cvtps_epi32( f ); v = _mm_packs_epi32( v, v ); v = _mm_packus_epi16( v, v );
+                int bits  = _mm_cvtsi128_si32( v ); memcpy( ptr, &bits, sizeof(int) );
+            } return;
+        #endif
+        }
+
+        float in[4]; value.store( in ); for( uint x=0; x<ch; ++x ){ switch( dp ){
+            case 1: { float f = in[x] < 0 ? 0 : in[x] > 1 ? 1 : in[x]; ptr[x] = (uchar)( f * 255.0f + 0.5f ); } break;
+            case 2: { ushort h = set_half( in[x] ); memcpy( ptr + x*2, &h, 2 ); } break;
+            case 4: memcpy( ptr + x*4, &in[x], 4 ); break;
+        }}
+    }
+
+    /*─······································································─*/
+
+    /* a fixed set of workers woken per loop; the caller drains chunks too,
+       so one thread less is spawned than GPU_CPU_THREADS asks for */
+    struct POOL {
+        std::mutex mtx, run; std::condition_variable wake, done;
+        std::thread* threads=nullptr; uint size=0; bool started=0, stop=0;
+        void (*task)( const void*, ulong, ulong ) = nullptr; const void* ctx=nullptr;
+        std::atomic<ulong> next; ulong count=0, grain=1, generation=0; uint pending=0;
+        except_t error; bool failed=0;
+
+        POOL() : next( 0 ) {}
+       ~POOL() { close(); }
+
+        void close() {
+            if( !started ){ return; }
+            { std::lock_guard<std::mutex> lock( mtx ); stop = 1; } wake.notify_all();
+            for( uint x=0; x<size; ++x ){ threads[x].join(); }
+            delete [] threads; threads = nullptr; size = 0; started = 0; stop = 0;
+        }
+    };
+
+    POOL _pool_; thread_local bool _worker_ = false;
+
+    /*─······································································─*/
+
+    void drain( POOL* pool ) {
+        ulong begin; while( ( begin = pool->next.fetch_add( pool->grain ) ) < pool->count ){
+            ulong end = begin + pool->grain; if( end > pool->count ){ end = pool->count; }
+            try { pool->task( pool->ctx, begin, end ); }
+            catch( except_t err ){ std::lock_guard<std::mutex> lock( pool->mtx );
+                   if( !pool->failed ){ pool->error = err; pool->failed = 1; } }
+            catch( ... ){ std::lock_guard<std::mutex> lock( pool->mtx );
+                   if( !pool->failed ){ pool->error = except_t("cpu kernel failed"); pool->failed = 1; } }
+        }
+    }
+
+    void work( POOL* pool ) {
+        _worker_ = true; ulong seen = 0; while( true ){
+            { std::unique_lock<std::mutex> lock( pool->mtx );
+              pool->wake.wait( lock, [&](){ return pool->stop || pool->generation!=seen; } );
+              if( pool->stop ){ return; } seen = pool->generation; }
+            drain( pool );
+            { std::lock_guard<std::mutex> lock( pool->mtx );
+              if( --pool->pending==0 ){ pool->done.notify_all(); } }
+        }
+    }
+
+    uint get_threads() noexcept {
+        uint out = GPU_CPU_THREADS; if( out==0 ){ out = std::thread::hardware_concurrency(); }
+        return out==0 ? 1 : out;
+    }
+
+    void start() {
+        if( _pool_.started ){ return; } _pool_.started = 1;
+        _pool_.size    = get_threads() - 1; if( _pool_.size==0 ){ return; }
+        _pool_.threads = new std::thread[ _pool_.size ];
+        for( uint x=0; x<_pool_.size; ++x ){ _pool_.threads[x] = std::thread( work, &_pool_ ); }
+    }
+
+    void stop() { _pool_.close(); }
+
+    /*─······································································─*/
+
+    template< class T >
+    void call( const void* ctx, ulong begin, ulong end ) { (*(const T*) ctx)( begin, end ); }
+
+    /* cb( begin, end ) over [0,count) in GPU_CPU_GRAIN chunks; calls from a
+       worker, or loops too small to split, run inline on the caller */
+    template< class T >
+    void parallel_for( ulong count, const T& cb, ulong grain=GPU_CPU_GRAIN ) {
+        if( count==0 ){ return; } start(); if( grain==0 ){ grain = 1; }
+        if( _pool_.size==0 || count<=grain || _worker_ ){ cb( 0, count ); return; }
+
+        std::lock_guard<std::mutex> run( _pool_.run ); POOL* pool = &_pool_;
+
+        { std::lock_guard<std::mutex> lock( pool->mtx );
+          pool->task  = &call<T>; pool->ctx = &cb; pool->count = count; pool->grain = grain;
+          pool->next.store( 0 ); pool->pending = pool->size; pool->failed = 0; ++pool->generation;
+        } pool->wake.notify_all();
+
+        _worker_ = true; drain( pool ); _worker_ = false; // nested loops run inline
+
+        { std::unique_lock<std::mutex> lock( pool->mtx );
+          pool->done.wait( lock, [&](){ return pool->pending==0; } );
+          pool->task = nullptr; pool->ctx = nullptr; }
+
+        if( pool->failed ){ pool->failed = 0; throw pool->error; }
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* the inputs of a gpu_t resolved once on the calling thread: samplers as raw
+   texel pointers and uniforms as texels, safe to read from every worker */
+namespace nodepp { namespace gpu { class cpu_t {
+protected:
+
+    struct SAMPLER { string_t name; matrix_t matrix; const uchar* data; uint width, height, format; };
+    struct UNIFORM { string_t name; texel_t value; };
+
+    struct NODE {
+        array_t<SAMPLER> samplers;
+        array_t<UNIFORM> uniforms;
+        uint width=0, height=0, format=OUT_DOUBLE4;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    template< class T > static texel_t get_scalar( const any_t& value ) {
+        return texel_t( (float) *value.as<ptr_t<T>>(), 0, 0, 0 );
+    }
+
+    template< class T > static texel_t get_vec2( const any_t& value ) {
+        auto x = value.as<ptr_t<T>>(); return texel_t( (float) x->x, (float) x->y, 0, 0 );
+    }
+
+    template< class T > static texel_t get_vec3( const any_t& value ) {
+        auto x = value.as<ptr_t<T>>(); return texel_t( (float) x->x, (float) x->y, (float) x->z, 0 );
+    }
+
+    template< class T > static texel_t get_vec4( const any_t& value ) {
+        auto x = value.as<ptr_t<T>>(); return texel_t( (float) x->x, (float) x->y, (float) x->z, (float) x->w );
+    }
+
+    void add_sampler( const string_t& name, matrix_t input ) {
+        SAMPLER item; item.name = name; item.matrix = input;
+        item.data  = &input.raw(); item.format = input.format();
+        item.width = input.width(); item.height= input.height();
+        obj->samplers.push( item );
+    }
+
+    void add_uniform( const string_t& name, const texel_t& value ) {
+        UNIFORM item; item.name = name; item.value = value; obj->uniforms.push( item );
+    }
+
+    const SAMPLER& get_sampler( int id ) const {
+        if( id<0 || (ulong) id>=obj->samplers.size() ){ throw except_t( "invalid cpu sampler" ); }
+        return obj->samplers[ id ];
+    }
+
+public:
+
+    cpu_t( gpu_t& kernel ) : obj( new NODE() ) {
+        auto& node = *kernel.obj; obj->width = node.width; obj->height = node.height; obj->format = node.format;
+        if( !node.outputs.empty() ){ throw except_t("cpu kernels support a single output"); }
+
+        for( auto x: node.vars.data() ){ auto& v = x.second.value; switch( x.second.type ){
+
+            case 0x01: add_uniform( x.first, get_scalar<bool> ( v ) ); break;
+            case 0x02: add_uniform( x.first, get_scalar<int>  ( v ) ); break;
+            case 0x03: add_uniform( x.first, get_scalar<uint> ( v ) ); break;
+            case 0x04: add_uniform( x.first, get_scalar<float>( v ) ); break;
+
+            case 0x11: add_uniform( x.first, get_vec2<bvec2_t>( v ) ); break;
+            case 0x12: add_uniform( x.first, get_vec2<ivec2_t>( v ) ); break;
+            case 0x13: add_uniform( x.first, get_vec2<uvec2_t>( v ) ); break;
+            case 0x14: add_uniform( x.first, get_vec2< vec2_t>( v ) ); break;
+
+            case 0x21: add_uniform( x.first, get_vec3<bvec3_t>( v ) ); break;
+            case 0x22: add_uniform( x.first, get_vec3<ivec3_t>( v ) ); break;
+            case 0x23: add_uniform( x.first, get_vec3<uvec3_t>( v ) ); break;
+            case 0x24: add_uniform( x.first, get_vec3< vec3_t>( v ) ); break;
+
+            case 0x31: add_uniform( x.first, get_vec4<bvec4_t>( v ) ); break;
+            case 0x32: add_uniform( x.first, get_vec4<ivec4_t>( v ) ); break;
+            case 0x33: add_uniform( x.first, get_vec4<uvec4_t>( v ) ); break;
+            case 0x34: add_uniform( x.first, get_vec4< vec4_t>( v ) ); break;
+
+            case 0x50: add_sampler( x.first, *v.as<ptr_t<matrix_t>>() ); break;
+            case 0x51: if( !_gpu_ ){ throw except_t("texture inputs need a gpu context"); }
+                       add_sampler( x.first, matrix_t( *v.as<ptr_t<RL::Texture2D>>() ) ); break;
+
+        }}
+    }
+
+    cpu_t() noexcept : obj( new NODE() ){}
+
+    /*─······································································─*/
+
+    uint format() const noexcept { return obj->format; }
+    uint height() const noexcept { return obj->height; }
+    uint width () const noexcept { return obj->width;  }
+
+    /* name lookups are a scan: resolve them once per job, before the
+       per-texel loop, and fetch by id inside it */
+    int sampler( const char* name ) const {
+        for( ulong x=0; x<obj->samplers.size(); ++x )
+           { if( strcmp( obj->samplers[x].name.get(), name )==0 ){ return x; } }
+        throw except_t( "invalid cpu sampler" );
+    }
+
+    int uniform( const char* name ) const {
+        for( ulong x=0; x<obj->uniforms.size(); ++x )
+           { if( strcmp( obj->uniforms[x].name.get(), name )==0 ){ return x; } }
+        throw except_t( "invalid cpu uniform" );
+    }
+
+    /*─······································································─*/
+
+    /* texelFetch(): integer coordinates, clamped to the edge */
+    texel_t fetch( int id, int x, int y ) const {
+        auto& s = get_sampler( id );
+        x = x < 0 ? 0 : x >= (int) s.width  ? s.width -1 : x;
+        y = y < 0 ? 0 : y >= (int) s.height ? s.height-1 : y;
+        return cpu::load( s.data, (ulong) y * s.width + x, s.format );
+    }
+
+    /* texture(): normalized coordinates, nearest texel, repeat wrap */
+    texel_t texture( int id, float u, float v ) const {
+        auto& s = get_sampler( id );
+        int x = (int) floorf( ( u - floorf( u ) ) * s.width  ); x = x >= (int) s.width  ? s.width -1 : x;
+        int y = (int) floorf( ( v - floorf( v ) ) * s.height ); y = y >= (int) s.height ? s.height-1 : y;
+        return cpu::load( s.data, (ulong) y * s.width + x, s.format );
+    }
+
+    /* uniforms widened to a texel: scalars in .x, bools as 0 or 1 */
+    texel_t get( int id ) const {
+        if( id<0 || (ulong) id>=obj->uniforms.size() ){ throw except_t( "invalid cpu uniform" ); }
+        return obj->uniforms[ id ].value;
+    }
+
+    texel_t fetch  ( const char* name, int x, int y )     const { return fetch  ( sampler( name ), x, y ); }
+    texel_t texture( const char* name, float u, float v ) const { return texture( sampler( name ), u, v ); }
+    texel_t get    ( const char* name ) /*-------------*/ const { return get    ( uniform( name ) ); }
+
+    /*─······································································─*/
+
+    /* cb( *this, x, y ) once per output texel; the shader's uv is ( x+0.5, y+0.5 ) */
+    template< class T >
+    matrix_t render( const T& cb ) const {
+        if( obj->width==0 || obj->height==0 ){ throw except_t("invalid texture"); }
+        matrix_t out( obj->width, obj->height, obj->format );
+        uchar* dst = &out.raw(); uint w = obj->width, fmt = obj->format;
+
+        cpu::parallel_for( (ulong) w * obj->height, [&]( ulong begin, ulong end ){
+            for( ulong i=begin; i<end; ++i ){ cpu::store( dst, i, fmt, cb( *this, i % w, i / w ) ); }
+        }); return out;
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace cpu {
+
+    /* lambda kernel for gpu_t::set_fallback():
+       texel_t cb( const cpu_t& ctx, uint x, uint y ) */
+    template< class T >
+    function_t<matrix_t,gpu_t&> kernel( T cb ) {
+        return function_t<matrix_t,gpu_t&>([=]( gpu_t& self ){
+            return cpu_t( self ).render( cb );
+        });
+    }
+
+    /* same, with the names resolved once per job: `ids = prepare( ctx )`
+       runs before the loop, then texel_t cb( ctx, ids, x, y ) per texel */
+    template< class P, class T >
+    function_t<matrix_t,gpu_t&> kernel( P prepare, T cb ) {
+        return function_t<matrix_t,gpu_t&>([=]( gpu_t& self ){
+            cpu_t ctx( self ); auto ids = prepare( (const cpu_t&) ctx );
+            return ctx.render([&]( const cpu_t& ctx, uint x, uint y ){ return cb( ctx, ids, x, y ); });
+        });
+    }
+
+    /*─······································································─*/
+
+    /* map( texel, x, y ) then combine( a, b ) along the REDUCE_* axis bits
+       ( 1 = rows, 2 = columns ); 1x1, 1xH or Wx1 RGBA32F like gpu::reduce_t */
+    template< class M, class C >
+    matrix_t reduce( const matrix_t& input, uint axis, const M& map, const C& combine ) {
+        uint w = input.width(), h = input.height(), fmt = input.format();
+        if( w==0 || h==0 ){ throw except_t("invalid reduce input"); }
+        if( axis==0 || axis>3 ){ throw except_t("invalid reduce axis"); }
+        const uchar* src = &input.raw();
+
+        if( axis==2 ){ // one lane per column, rows walked in order
+            matrix_t out( w, 1, OUT_DOUBLE4 ); float* dst = (float*) &out.raw();
+            parallel_for( w, [&]( ulong begin, ulong end ){ for( ulong x=begin; x<end; ++x ){
+                texel_t acc = map( load( src, x, fmt ), x, 0 );
+                for( ulong y=1; y<h; ++y ){ acc = combine( acc, map( load( src, y * w + x, fmt ), x, y ) ); }
+                acc.store( dst + x * 4 );
+            }}, 1 + GPU_CPU_GRAIN / h ); return out;
+        }
+
+        matrix_t rows( 1, h, OUT_DOUBLE4 ); float* dst = (float*) &rows.raw();
+        parallel_for( h, [&]( ulong begin, ulong end ){ for( ulong y=begin; y<end; ++y ){
+            texel_t acc = map( load( src, y * w, fmt ), 0, y );
+            for( ulong x=1; x<w; ++x ){ acc = combine( acc, map( load( src, y * w + x, fmt ), x, y ) ); }
+            acc.store( dst + y * 4 );
+        }}, 1 + GPU_CPU_GRAIN / w ); if( axis==1 ){ return rows; }
+
+        matrix_t out( 1, 1, OUT_DOUBLE4 ); texel_t acc = texel_t::load( dst );
+        for( ulong y=1; y<h; ++y ){ acc = combine( acc, texel_t::load( dst + y * 4 ) ); }
+        acc.store( (float*) &out.raw() ); return out;
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
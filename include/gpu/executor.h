@@ -0,0 +1,425 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_EXECUTOR
+#define NODEPP_GPU_EXECUTOR
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <map>
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_EXECUTOR_BATCH
+#define GPU_EXECUTOR_BATCH 64
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class executor_t {
+protected:
+
+    /* submit() issues GL commands, finish() waits for and collects them;
+       every submit of a batch runs before a single flush, then every finish */
+    struct JOB {
+        std::atomic<JOB*> next; std::atomic<int> state;
+        function_t<void>  submit, finish; except_t error;
+        JOB() : next( nullptr ), state( 0 ) {}
+    };
+
+    /* intrusive multi-producer / single-consumer queue: producers only
+       exchange the head, the worker is the only one walking the tail */
+    struct NODE {
+        JOB stub; std::atomic<JOB*> head; JOB* tail;
+        std::atomic<bool> running; std::thread thread;
+        std::map<uint,std::map<std::string,int>> locations; // worker only
+        ulong generation=0; /*--------------------------*/ // worker only
+        NODE() : head( &stub ), tail( &stub ), running( false ) {}
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    static std::atomic<bool>& get_owner() {
+        static std::atomic<bool> owner( false ); return owner;
+    }
+
+    static void set_context( bool current ) {
+    #ifdef GPU_HEADLESS
+        auto& ctx = egl::_egl_; if( current ){
+            eglMakeCurrent( ctx.display, ctx.surface, ctx.surface, ctx.context );
+        } else { eglMakeCurrent( ctx.display, nullptr, nullptr, nullptr ); }
+    #else
+        glfwMakeContextCurrent( current ? RL::GetWindowHandle() : nullptr );
+    #endif
+    }
+
+    /*─······································································─*/
+
+    static void push( NODE* obj, JOB* job ) noexcept {
+        job->next.store( nullptr, std::memory_order_relaxed );
+        auto prev = obj->head.exchange( job, std::memory_order_acq_rel );
+        prev->next.store( job, std::memory_order_release );
+    }
+
+    static JOB* pop( NODE* obj ) noexcept {
+        JOB* tail = obj->tail;
+        JOB* next = tail->next.load( std::memory_order_acquire );
+
+        if( tail == &obj->stub ){
+            if( next == nullptr ){ return nullptr; }
+            obj->tail = next; tail = next;
+            next = next->next.load( std::memory_order_acquire );
+        }
+
+        if( next != nullptr ){ obj->tail = next; return tail; }
+        if( tail != obj->head.load( std::memory_order_acquire ) ){ return nullptr; }
+
+        push( obj, &obj->stub ); next = tail->next.load( std::memory_order_acquire );
+        if( next != nullptr ){ obj->tail = next; return tail; } return nullptr;
+    }
+
+    /*─······································································─*/
+
+    /* matrix pixels that still have to reach a texture; a texture id of
+       0 means the pool had nothing idle and the worker allocates one */
+    struct UPLOAD {
+        matrix_t::NODE* node; uchar* data; RL::Texture2D texture;
+        ulong bytes=0, time=0; bool owned=0, fresh=0;
+    };
+
+    /* a uniform resolved on the calling thread: samplers keep the texture
+       id or the index of their upload, values are copied out */
+    struct UNIFORM {
+        string_t name; int flag=-1; uint texture=0;
+        long upload=-1; uchar data[16];
+    };
+
+    /* everything a worker job reads: raw ids, raw pointers and plain
+       values, never a refcounted handle */
+    struct PLAN {
+        array_t<UPLOAD>  uploads ; array_t<UNIFORM> uniforms;
+        array_t<uint>    outputs ; string_t source; RL::Shader shader = { 0 };
+        RL::RenderTexture2D target = { 0 }; gpu_t::PBO* read=nullptr; uchar* out=nullptr;
+        ulong bytes=0, compile=0, readback=0, generation=0;
+    };
+
+    /*─······································································─*/
+
+    /* the worker never copies or releases a handle: ptr_t counts are not
+       atomic. Jobs only read what their PLAN resolved beforehand */
+    static void run( NODE* node ) {
+        set_context( true ); auto gl = RL::GL::Load();
+        JOB* batch[ GPU_EXECUTOR_BATCH ];
+
+        while( node->running.load( std::memory_order_acquire ) ){
+            pool::collect(); // textures released on the caller's thread
+
+            ulong count = 0; while( count < GPU_EXECUTOR_BATCH ){
+                  JOB* job = pop( node ); if( job==nullptr ){ break; }
+                  batch[ count++ ] = job;
+            }
+
+            if( count==0 ){
+                std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+                continue;
+            }
+
+            // states are published only once the worker is done with the job,
+            // the caller's loop deletes it as soon as it sees them
+            bool failed[ GPU_EXECUTOR_BATCH ];
+
+            for( ulong x=0; x<count; ++x ){ failed[x] = 0;
+                 try { batch[x]->submit(); }
+                 catch( except_t err ){ batch[x]->error = err; failed[x] = 1; }
+                 catch( ... ){ batch[x]->error = except_t("gpu job failed"); failed[x] = 1; }
+            }    gl->Flush();
+
+            for( ulong x=0; x<count; ++x ){ if( !failed[x] ){
+                 try { batch[x]->finish(); }
+                 catch( except_t err ){ batch[x]->error = err; failed[x] = 1; }
+                 catch( ... ){ batch[x]->error = except_t("gpu job failed"); failed[x] = 1; }
+            }    batch[x]->state.store( failed[x] ? -1 : 1, std::memory_order_release ); }
+        }
+
+        set_context( false );
+    }
+
+    /*─······································································─*/
+
+    static void run_uploads( PLAN& plan ) {
+        for( auto& x: plan.uploads ){ auto time = stats::now(); auto& tex = x.texture;
+             if( tex.id==0 ){
+                 tex.id = RL::rlLoadTexture( nullptr, tex.width, tex.height, tex.format, 1 );
+                 if( tex.id==0 ){ throw except_t( "gpu texture allocation failed" ); } x.fresh = 1;
+             }   RL::UpdateTexture( tex, x.data ); x.time = stats::now() - time;
+        }
+    }
+
+    static void run_compile( PLAN& plan ) {
+        if( plan.shader.id!=0 ){ return; } auto time = stats::now();
+        plan.shader = RL::LoadShaderFromMemory( nullptr, plan.source.get() );
+        if( !RL::IsShaderValid( plan.shader ) ){ plan.shader.id = 0; throw except_t("Invalid Shader"); }
+        plan.compile = stats::now() - time;
+    }
+
+    static void run_draw( NODE* node, PLAN& plan ) {
+        auto& target = plan.target; ulong n = plan.outputs.size();
+        // ids of programs dropped by cache::clear() get reused by the driver
+        if( node->generation!=plan.generation ){ node->locations.clear(); node->generation = plan.generation; }
+        auto& locs   = node->locations[ plan.shader.id ];
+
+        for( ulong x=0; x<n; ++x ){
+             RL::rlFramebufferAttach( target.id, plan.outputs[x],
+                 RL::RL_ATTACHMENT_COLOR_CHANNEL1 + x, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+        }
+
+        RL::rlDrawRenderBatchActive(); RL::BeginTextureMode( target );
+        if( n>0 ){ RL::rlActiveDrawBuffers( n+1 ); } RL::ClearBackground( RL::BLACK );
+        RL::BeginShaderMode( plan.shader ); RL::rlEnableShader( plan.shader.id );
+
+        for( auto& x: plan.uniforms ){ std::string key( x.name.get() );
+             if( !locs.count( key ) ){ locs[ key ] = RL::rlGetLocationUniform( plan.shader.id, key.c_str() ); }
+             int loc = locs[ key ]; if( loc<0 ){ continue; } if( x.flag>=0 )
+               { RL::rlSetUniform( loc, x.data, x.flag, 1 ); continue; }
+             uint id = x.upload<0 ? x.texture : plan.uploads[ x.upload ].texture.id;
+             RL::rlSetUniformSampler( loc, id );
+        }
+
+        RL::DrawRectangle( 0, 0, target.texture.width, target.texture.height, RL::WHITE );
+        RL::EndShaderMode(); if( n>0 ){ RL::rlActiveDrawBuffers( 1 ); } RL::EndTextureMode();
+
+        for( ulong x=0; x<n; ++x ){
+             RL::rlFramebufferAttach( target.id, 0,
+                 RL::RL_ATTACHMENT_COLOR_CHANNEL1 + x, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+        }
+    }
+
+    static void run_readback( PLAN& plan ) {
+        auto gl = RL::GL::Load(); auto& slot = *plan.read; auto time = stats::now();
+
+        if( slot.image.data!=nullptr ){ // no PBO support, read synchronously in submit
+            memcpy( plan.out, slot.image.data, slot.size<plan.bytes ? slot.size : plan.bytes );
+            RL::UnloadImage( slot.image ); slot.image.data = nullptr;
+            plan.readback = stats::now() - time; return;
+        }
+
+        while( slot.fence!=nullptr ){
+             auto state = gl->ClientWaitSync( slot.fence, RL::GL::SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL );
+             if  ( state == RL::GL::TIMEOUT_EXPIRED ){ continue; }
+             gl->DeleteSync( slot.fence ); slot.fence = nullptr;
+             if  ( state == RL::GL::WAIT_FAILED ){ throw except_t( "gpu readback failed" ); }
+        }
+
+        gl->BindBuffer( RL::GL::PIXEL_PACK_BUFFER, slot.id );
+        auto data = gl->MapBufferRange( RL::GL::PIXEL_PACK_BUFFER, 0, slot.size, RL::GL::MAP_READ_BIT );
+        if( data!=nullptr ){ memcpy( plan.out, data, slot.size<plan.bytes ? slot.size : plan.bytes );
+                             gl->UnmapBuffer( RL::GL::PIXEL_PACK_BUFFER ); }
+        gl->BindBuffer( RL::GL::PIXEL_PACK_BUFFER, 0 ); plan.readback = stats::now() - time;
+        if( data==nullptr ){ throw except_t( "gpu readback failed" ); }
+    }
+
+    /*─······································································─*/
+
+    /* caller thread: takes an idle texture for a stale matrix, or leaves
+       the allocation to the worker */
+    static long get_upload( PLAN& plan, const matrix_t& input ) {
+        auto& node = input.obj; if( node->texture.id!=0 && !node->dirty ){ return -1; }
+
+        UPLOAD item; item.node = &(*node); item.data = &node->data;
+        item.bytes = node->data.size(); item.texture = node->texture;
+        item.owned = item.texture.id!=0;
+
+        if( !item.owned ){ pool::ITEM idle;
+        if( pool::take( false, node->width, node->height, node->format, idle ) )
+             { item.texture = idle.target.texture; }
+        else { item.texture.width = node->width; item.texture.height = node->height;
+               item.texture.format= node->format; item.texture.mipmaps= 1; }
+        }    plan.uploads.push( item ); return plan.uploads.size()-1;
+    }
+
+    /* caller thread: hands uploaded textures to their matrices, or back
+       to the pool when the job failed or another job got there first */
+    static void set_uploads( PLAN& plan, bool done ) noexcept {
+        for( auto& x: plan.uploads ){ auto& tex = x.texture;
+             if( x.fresh ){ pool::ITEM item; item.bytes = pool::get_bytes( tex.width, tex.height, tex.format ); pool::add_miss( item ); }
+             if( done ){ stats::add_upload( x.time, x.bytes ); }
+             if( x.owned ){ if( done ){ x.node->dirty = 0; } continue; } if( tex.id==0 ){ continue; }
+             if( done && x.node->texture.id==0 ){ x.node->texture = tex; x.node->dirty = 0; continue; }
+             pool::put_texture( tex );
+        }
+    }
+
+    static void get_uniforms( PLAN& plan, const gpu_t& kernel ) {
+        for( auto x: kernel.obj->vars.data() ){ auto& y = x.second; UNIFORM item;
+             const void* data=nullptr; ulong size=0; item.name = x.first;
+             item.flag = get_uniform( y.type, y.value, data, size ); memset( item.data, 0, 16 );
+
+             if( item.flag>=0 ){ memcpy( item.data, data, size ); }
+             else if( y.type==0x50 ){
+                  auto mat = y.value.as<ptr_t<matrix_t>>();
+                  item.upload = get_upload( plan, *mat ); item.texture = mat->obj->texture.id;
+             }
+             else if( y.type==0x51 ){ item.texture = y.value.as<ptr_t<RL::Texture2D>>()->id; }
+
+        plan.uniforms.push( item ); }
+    }
+
+    /* caller thread: a cached program is adopted right away, otherwise
+       the source goes along and the worker links it */
+    void get_shader( PLAN& plan, const gpu_t& kernel ) const {
+        auto& node = kernel.obj; plan.generation = cache::_generation_; if( kernel.is_stale() ){
+            plan.source = kernel.get_program(); auto prog = cache::find( plan.source );
+            if( prog.null() ){ return; } kernel.set_program( prog ); plan.source = string_t();
+        }   plan.shader = *node->shader;
+        // uniforms written here are not the ones the kernel's slots recorded
+        cache::_owner_[ plan.shader.id ] = &obj;
+    }
+
+    /* caller thread: caches what the worker linked; a program linked twice
+       meanwhile is unloaded on the worker again */
+    void set_shader( PLAN& plan, const gpu_t& kernel ) const {
+        if( plan.source.empty() || plan.shader.id==0 ){ return; }
+        stats::add_compile( plan.compile ); auto prog = cache::find( plan.source );
+
+        if( prog.null() ){ prog = cache::set( plan.source, plan.shader ); }
+        else if( !is_closed() ){ auto self = &obj; auto shader = plan.shader;
+            add<bool>([=](){ self->locations.erase( shader.id ); RL::UnloadShader( shader ); }, [=](){ return true; });
+        }   if( kernel.is_stale() ){ kernel.set_program( prog ); }
+    }
+
+public:
+
+    executor_t() noexcept : obj( new NODE() ){}
+    virtual ~executor_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return !obj->running.load(); }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    /* joins the worker and hands the context back to the calling thread;
+       jobs still queued at this point are rejected */
+    void free() const noexcept { if( !is_closed() ){
+        obj->running.store( false ); obj->thread.join();
+        set_context( true ); get_owner().store( false );
+        pool::_defer_.store( false ); pool::collect();
+        while( auto job = pop( &obj ) ){
+            job->error = except_t("gpu executor closed");
+            job->state.store( -1, std::memory_order_release );
+        }
+    }}
+
+    /*─······································································─*/
+
+    /* moves the context created by start_machine() onto the worker thread;
+       from here on every GL call has to go through this executor */
+    executor_t& start() {
+        if( !_gpu_ ){ throw except_t("gpu machine not started"); }
+        if( !is_closed() ){ return *this; }
+        if( get_owner().exchange( true ) ){ throw except_t("gpu context already owned"); }
+
+        get_max_texture_size(); has_readback(); // cached now, the caller can't query them later
+        set_context( false ); pool::_defer_.store( true );
+        obj->locations.clear(); obj->running.store( true );
+        obj->thread = std::thread( run, &obj ); return *this;
+    }
+
+    /*─······································································─*/
+
+    /* submit() and finish() run on the worker, on either side of the flush
+       their batch shares, and may only touch raw GL ids and memory the job
+       owns; done() and fail() run back on this thread, which keeps every
+       handle, the pool, the cache and the stats */
+    template< class T >
+    promise_t<T,except_t> add( function_t<void> submit, function_t<void> finish,
+                               function_t<T> done, function_t<void> fail ) const {
+        if( is_closed() ){ throw except_t("gpu executor closed"); }
+
+        auto job = new JOB(); job->submit = submit; job->finish = finish;
+        push( &obj, job );
+
+    return promise_t<T,except_t>([=](
+        function_t<void,T> res, function_t<void,except_t> rej
+    ){ process::add([=](){
+        int state = job->state.load( std::memory_order_acquire );
+        if( state==0 ){ return 1; }
+
+        except_t err = job->error; delete job;
+        if( state<0 ){ fail(); rej( err ); return -1; }
+        try { T value = done(); res( value ); } catch( except_t err ){ rej( err ); }
+
+    return -1; }); }); }
+
+    template< class T >
+    promise_t<T,except_t> add( function_t<void> submit, function_t<T> done ) const {
+        return add<T>( submit, [=](){}, done, [=](){} );
+    }
+
+    /* the task runs on the worker, so whatever it returns must not share
+       a handle with this thread */
+    template< class T >
+    promise_t<T,except_t> add( function_t<T> task ) const {
+        auto out = ptr_t<T>( new T() );
+        return add<T>( [=](){ *out = task(); }, [=](){ return *out; } );
+    }
+
+    /*─······································································─*/
+
+    promise_t<matrix_t,except_t> upload( const matrix_t& input ) const {
+        auto plan = ptr_t<PLAN>( new PLAN() ); get_upload( *plan, input );
+    return add<matrix_t>( [=](){ run_uploads( *plan ); }, [=](){}, [=](){
+        set_uploads( *plan, true ); return input;
+    }, [=](){ set_uploads( *plan, false ); }); }
+
+    promise_t<gpu_t,except_t> compile( const gpu_t& kernel ) const {
+        if( kernel.is_closed() ){ throw except_t("gpu kernel closed"); }
+        auto plan = ptr_t<PLAN>( new PLAN() ); get_shader( *plan, kernel ); executor_t self = *this;
+    return add<gpu_t>( [=](){ run_compile( *plan ); }, [=](){}, [=](){
+        stats::scope_t scope( &kernel.obj->stats ); self.set_shader( *plan, kernel ); return kernel;
+    }, [=](){}); }
+
+    /* draw and PBO readback are issued in the submit phase, so a batch of
+       dispatches shares one flush and the transfers overlap each other */
+    promise_t<matrix_t,except_t> dispatch( const gpu_t& kernel ) const {
+        auto& node = kernel.obj; if( kernel.is_closed() ){ throw except_t("gpu kernel closed"); }
+        if( node->texture.null() ){ throw except_t("invalid texture"); }
+        if( kernel.is_tiled() ){ throw except_t("executor does not support tiled kernels"); }
+
+        auto plan = ptr_t<PLAN>( new PLAN() ); get_shader( *plan, kernel ); get_uniforms( *plan, kernel );
+        plan->target = *node->texture; for( auto& x: node->outputs ){ plan->outputs.push( x.texture.id ); }
+
+        auto& tex = plan->target.texture; matrix_t out( tex.width, tex.height, tex.format );
+        auto read = kernel.get_ring_slot(); plan->read = &(*read); plan->out = &out.obj->data;
+        plan->bytes = out.obj->data.size();
+        auto self = &obj; executor_t exec = *this;
+
+    return add<matrix_t>( [=](){
+        run_uploads( *plan ); run_compile( *plan ); run_draw( self, *plan );
+        gpu_t::set_readback( *plan->read, plan->target );
+    }, [=](){ run_readback( *plan ); }, [=](){
+        stats::scope_t scope( &kernel.obj->stats ); read->busy = 0;
+        set_uploads( *plan, true ); exec.set_shader( *plan, kernel );
+        stats::add_dispatch(); stats::add_readback( plan->readback, read->size ); return out;
+    }, [=](){
+        stats::scope_t scope( &kernel.obj->stats ); read->busy = 0;
+        set_uploads( *plan, false ); exec.set_shader( *plan, kernel );
+    }); }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
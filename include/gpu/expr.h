@@ -0,0 +1,266 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_EXPR
+#define NODEPP_GPU_EXPR
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "cpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { enum EXPR_OP {
+    EXPR_MATRIX, EXPR_SCALAR,
+    EXPR_ADD , EXPR_SUB , EXPR_MUL , EXPR_DIV , EXPR_NEG  ,
+    EXPR_MIN , EXPR_MAX , EXPR_POW , EXPR_CLAMP, EXPR_MIX ,
+    EXPR_ABS , EXPR_SQRT, EXPR_EXP , EXPR_LOG  , EXPR_SIN , EXPR_COS ,
+    EXPR_TAN , EXPR_TANH, EXPR_FLOOR, EXPR_CEIL, EXPR_FRACT, EXPR_SIGN
+};}}
+
+namespace nodepp { namespace gpu { namespace expr {
+    const char* _names_[] = {
+        "", "", "+", "-", "*", "/", "-",
+        "min", "max", "pow", "clamp", "mix",
+        "abs", "sqrt", "exp", "log", "sin", "cos",
+        "tan", "tanh", "floor", "ceil", "fract", "sign"
+    };
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* a lazy element-wise expression over equally sized matrices; nothing runs
+   until get(), which emits one fused kernel. Leaves are named by position
+   and scalars become uniforms, so every expression of the same shape
+   shares one program in gpu::cache */
+namespace nodepp { namespace gpu { class expr_t {
+protected:
+
+    struct NODE {
+        uchar op=EXPR_SCALAR; float value=0;
+        array_t<ptr_t<NODE>> args;
+        matrix_t matrix;
+    };  ptr_t<NODE> obj;
+
+    /* the same tree in postfix order for the CPU path */
+    struct INST { uchar op; ulong slot; };
+
+    struct PROGRAM {
+        array_t<matrix_t> matrices;
+        array_t<float>    scalars;
+        array_t<INST>     code;
+        string_t source; ulong depth=0;
+    };
+
+    /*─······································································─*/
+
+    static ulong get_slot( PROGRAM& prog, const matrix_t& input ) {
+        auto data = input.get_image().data; for( ulong x=0; x<prog.matrices.size(); ++x ){
+        if ( prog.matrices[x].get_image().data==data ){ return x; }
+        }    prog.matrices.push( input ); return prog.matrices.size()-1;
+    }
+
+    static ulong get_program( PROGRAM& prog, const ptr_t<NODE>& node, string_t& out ) {
+        switch( node->op ){
+
+            case EXPR_MATRIX: { ulong slot = get_slot( prog, node->matrix );
+                out = regex::format( "texture( gpu_expr_m${0}, uv / gpu_expr_size )", string::to_string( slot ) );
+                prog.code.push( INST({ EXPR_MATRIX, slot }) ); return 1;
+            }
+
+            case EXPR_SCALAR: { ulong slot = prog.scalars.size(); prog.scalars.push( node->value );
+                out = regex::format( "vec4( gpu_expr_s${0} )", string::to_string( slot ) );
+                prog.code.push( INST({ EXPR_SCALAR, slot }) ); return 1;
+            }
+
+        }
+
+        ulong depth = 0; array_t<string_t> args;
+        for( ulong x=0; x<node->args.size(); ++x ){ string_t arg;
+             ulong need = get_program( prog, node->args[x], arg ) + x;
+             if( need>depth ){ depth = need; } args.push( arg );
+        }    prog.code.push( INST({ node->op, 0 }) );
+
+        string_t name = expr::_names_[ node->op ]; switch( node->op ){
+            case EXPR_ADD: case EXPR_SUB: case EXPR_MUL: case EXPR_DIV:
+                 out = "( " + args[0] + " " + name + " " + args[1] + " " + ")"; break;
+            case EXPR_NEG:
+                 out = "( -" + args[0] + " )"; break;
+            default: out = name + "( "; for( ulong x=0; x<args.size(); ++x ){
+                 out += ( x==0 ? "" : ", " ) + args[x];
+            }    out += " )"; break;
+        }
+
+        return depth;
+    }
+
+    /*─······································································─*/
+
+    static texel_t get_lane( const texel_t& a, float (*cb)( float ) ) noexcept {
+        return texel_t( cb( a[0] ), cb( a[1] ), cb( a[2] ), cb( a[3] ) );
+    }
+
+    static float get_sign ( float x ) noexcept { return x>0 ? 1.0f : x<0 ? -1.0f : 0.0f; }
+    static float get_fract( float x ) noexcept { return x - ::floorf( x ); }
+
+    /* runs the postfix code over [begin,end) with one stack per chunk */
+    static void run_program( const PROGRAM& prog, const ptr_t<const uchar*>& data, uchar* out,
+                             uint format, ulong begin, ulong end ) {
+        ptr_t<texel_t> stack( prog.depth+1, texel_t() ); for( ulong i=begin; i<end; ++i ){ ulong top=0;
+        for( auto& inst: prog.code ){ switch( inst.op ){
+            case EXPR_MATRIX: stack[top++] = cpu::load( data[inst.slot], i, prog.matrices[inst.slot].format() ); break;
+            case EXPR_SCALAR: stack[top++] = texel_t( prog.scalars[inst.slot] ); break;
+            case EXPR_CLAMP : top-=2; stack[top-1] = clamp( stack[top-1], stack[top], stack[top+1] ); break;
+            case EXPR_MIX   : top-=2; stack[top-1] = mix  ( stack[top-1], stack[top], stack[top+1] ); break;
+            case EXPR_ADD   : --top;  stack[top-1] = stack[top-1] + stack[top]; break;
+            case EXPR_SUB   : --top;  stack[top-1] = stack[top-1] - stack[top]; break;
+            case EXPR_MUL   : --top;  stack[top-1] = stack[top-1] * stack[top]; break;
+            case EXPR_DIV   : --top;  stack[top-1] = stack[top-1] / stack[top]; break;
+            case EXPR_MIN   : --top;  stack[top-1] = min( stack[top-1], stack[top] ); break;
+            case EXPR_MAX   : --top;  stack[top-1] = max( stack[top-1], stack[top] ); break;
+            case EXPR_POW   : --top;  { texel_t& a = stack[top-1]; const texel_t& b = stack[top];
+                a = texel_t( ::powf( a[0], b[0] ), ::powf( a[1], b[1] ), ::powf( a[2], b[2] ), ::powf( a[3], b[3] ) );
+            } break;
+            case EXPR_NEG   : stack[top-1] = -stack[top-1]; break;
+            case EXPR_ABS   : stack[top-1] = abs ( stack[top-1] ); break;
+            case EXPR_SQRT  : stack[top-1] = sqrt( stack[top-1] ); break;
+            case EXPR_EXP   : stack[top-1] = get_lane( stack[top-1], ::expf   ); break;
+            case EXPR_LOG   : stack[top-1] = get_lane( stack[top-1], ::logf   ); break;
+            case EXPR_SIN   : stack[top-1] = get_lane( stack[top-1], ::sinf   ); break;
+            case EXPR_COS   : stack[top-1] = get_lane( stack[top-1], ::cosf   ); break;
+            case EXPR_TAN   : stack[top-1] = get_lane( stack[top-1], ::tanf   ); break;
+            case EXPR_TANH  : stack[top-1] = get_lane( stack[top-1], ::tanhf  ); break;
+            case EXPR_FLOOR : stack[top-1] = get_lane( stack[top-1], ::floorf ); break;
+            case EXPR_CEIL  : stack[top-1] = get_lane( stack[top-1], ::ceilf  ); break;
+            case EXPR_FRACT : stack[top-1] = get_lane( stack[top-1], get_fract ); break;
+            case EXPR_SIGN  : stack[top-1] = get_lane( stack[top-1], get_sign  ); break;
+        }}  cpu::store( out, i, format, stack[0] ); }
+    }
+
+    /*─······································································─*/
+
+    /* default output: float storage with as many lanes as the widest leaf */
+    static uint get_format( const PROGRAM& prog ) noexcept {
+        uint ch = 1; for( auto& x: prog.matrices ){ if( x.channels()>ch ){ ch = x.channels(); } }
+        return ch==1 ? OUT_DOUBLE : ch==3 ? OUT_DOUBLE3 : OUT_DOUBLE4;
+    }
+
+    gpu_t get_kernel( uint format ) const {
+        auto prog = type::bind( PROGRAM() );
+        prog->depth = get_program( *prog, obj, prog->source );
+
+        if( prog->matrices.empty() ){ throw except_t("expression has no matrix"); }
+        if( format==0 ){ format = get_format( *prog ); }
+
+        uint w = prog->matrices[0].width(), h = prog->matrices[0].height();
+        for( auto& x: prog->matrices ){ if( x.width()!=w || x.height()!=h )
+           { throw except_t("expression matrices must share one size"); }
+        }
+
+        gpu_t kernel( "return " + prog->source + ";" );
+        kernel.set_output( w, h, format ).set_input( vec2_t({ (float) w, (float) h }), "gpu_expr_size" );
+
+        for( ulong x=0; x<prog->matrices.size(); ++x )
+           { kernel.set_input( prog->matrices[x], "gpu_expr_m" + string::to_string( x ) ); }
+        for( ulong x=0; x<prog->scalars.size(); ++x )
+           { kernel.set_input( prog->scalars[x], "gpu_expr_s" + string::to_string( x ) ); }
+
+        kernel.set_fallback([=]( gpu_t& ){
+            matrix_t out( w, h, format ); uchar* dst = &out.raw();
+            ptr_t<const uchar*> data( prog->matrices.size(), nullptr );
+            for( ulong x=0; x<data.size(); ++x ){ data[x] = &prog->matrices[x].raw(); }
+            cpu::parallel_for( (ulong) w * h, [&]( ulong begin, ulong end ){
+                run_program( *prog, data, dst, format, begin, end );
+            }); return out;
+        });
+
+        return kernel;
+    }
+
+    static expr_t get_op( uchar op, array_t<expr_t> args ) {
+        expr_t out; out.obj->op = op;
+        for( auto& x: args ){ out.obj->args.push( x.obj ); }
+        return out;
+    }
+
+public:
+
+    expr_t( const matrix_t& input ) : obj( new NODE() ) { obj->op = EXPR_MATRIX; obj->matrix = input; }
+    expr_t( float value ) noexcept : obj( new NODE() ) { obj->op = EXPR_SCALAR; obj->value = value; }
+    expr_t() noexcept : obj( new NODE() ) {}
+
+    /*─······································································─*/
+
+    static expr_t call( uchar op, const expr_t& a ){ return get_op( op, { a } ); }
+    static expr_t call( uchar op, const expr_t& a, const expr_t& b ){ return get_op( op, { a, b } ); }
+    static expr_t call( uchar op, const expr_t& a, const expr_t& b, const expr_t& c ){ return get_op( op, { a, b, c } ); }
+
+    /*─······································································─*/
+
+    /* the fused source, e.g. for logging */
+    string_t get_source() const {
+        PROGRAM prog; get_program( prog, obj, prog.source ); return prog.source;
+    }
+
+    /* format 0 picks a float format with the channel count of the widest input */
+    matrix_t get( uint format=0 ) const { return get_kernel( format )(); }
+
+    promise_t<matrix_t,except_t> run_async( uint format=0 ) const { return get_kernel( format ).run_async(); }
+
+    operator matrix_t() const { return get(); }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* found through matrix_t as well, so `a * b + c` on matrices builds a tree */
+namespace nodepp { namespace gpu {
+
+    inline expr_t operator+( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_ADD, a, b ); }
+    inline expr_t operator-( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_SUB, a, b ); }
+    inline expr_t operator*( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_MUL, a, b ); }
+    inline expr_t operator/( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_DIV, a, b ); }
+    inline expr_t operator-( const expr_t& a ) /*----------*/ { return expr_t::call( EXPR_NEG, a ); }
+
+}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* named functions live here rather than in gpu:: so they never hide the
+   <cmath> overloads for code inside the namespace */
+namespace nodepp { namespace gpu { namespace expr {
+
+    inline expr_t min  ( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_MIN, a, b ); }
+    inline expr_t max  ( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_MAX, a, b ); }
+    inline expr_t pow  ( const expr_t& a, const expr_t& b ){ return expr_t::call( EXPR_POW, a, b ); }
+
+    inline expr_t clamp( const expr_t& a, const expr_t& lo, const expr_t& hi ){ return expr_t::call( EXPR_CLAMP, a, lo, hi ); }
+    inline expr_t mix  ( const expr_t& a, const expr_t& b , const expr_t& t  ){ return expr_t::call( EXPR_MIX  , a, b , t  ); }
+
+    inline expr_t abs  ( const expr_t& a ){ return expr_t::call( EXPR_ABS  , a ); }
+    inline expr_t sqrt ( const expr_t& a ){ return expr_t::call( EXPR_SQRT , a ); }
+    inline expr_t exp  ( const expr_t& a ){ return expr_t::call( EXPR_EXP  , a ); }
+    inline expr_t log  ( const expr_t& a ){ return expr_t::call( EXPR_LOG  , a ); }
+    inline expr_t sin  ( const expr_t& a ){ return expr_t::call( EXPR_SIN  , a ); }
+    inline expr_t cos  ( const expr_t& a ){ return expr_t::call( EXPR_COS  , a ); }
+    inline expr_t tan  ( const expr_t& a ){ return expr_t::call( EXPR_TAN  , a ); }
+    inline expr_t tanh ( const expr_t& a ){ return expr_t::call( EXPR_TANH , a ); }
+    inline expr_t floor( const expr_t& a ){ return expr_t::call( EXPR_FLOOR, a ); }
+    inline expr_t ceil ( const expr_t& a ){ return expr_t::call( EXPR_CEIL , a ); }
+    inline expr_t fract( const expr_t& a ){ return expr_t::call( EXPR_FRACT, a ); }
+    inline expr_t sign ( const expr_t& a ){ return expr_t::call( EXPR_SIGN , a ); }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -15,10 +15,14 @@
 /*────────────────────────────────────────────────────────────────────────────*/
 
 #include <nodepp/nodepp.h>
+#include <nodepp/promise.h>
 #include <nodepp/stream.h>
 #include <nodepp/map.h>
 #include <nodepp/any.h>
 #include <nodepp/fs.h>
+#include <chrono>
+#include <atomic>
+#include <mutex>
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
@@ -43,16 +47,8 @@ namespace RL { RenderTexture2D LoadRenderTexture( int width, int height, int for
         target.texture.format = format;
         target.texture.mipmaps = 1;
 
-        // Create depth renderbuffer/texture
-        target.depth.id = rlLoadTextureDepth(width, height, true);
-        target.depth.width = width;
-        target.depth.height = height;
-        target.depth.format = 19;       //DEPTH_COMPONENT_24BIT?
-        target.depth.mipmaps = 1;
-
-        // Attach color texture and depth renderbuffer/texture to FBO
+        // Attach color texture to FBO, compute never reads depth
         rlFramebufferAttach(target.id, target.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
-        rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
 
         // Check if fbo is complete with attachments (valid)
         if (rlFramebufferComplete(target.id)) TRACELOG(LOG_INFO, "FBO: [ID %i] Framebuffer object created successfully", target.id);
@@ -65,10 +61,163 @@ namespace RL { RenderTexture2D LoadRenderTexture( int width, int height, int for
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
+#ifdef _WIN32
+    #define GPU_GLAPI __stdcall
+#else
+    #define GPU_GLAPI
+#endif
+
+#ifdef GPU_HEADLESS
+extern "C" {
+    void*        eglGetProcAddress      ( const char* name );
+    void*        eglGetDisplay          ( void* native );
+    unsigned int eglInitialize          ( void* dpy, int* major, int* minor );
+    unsigned int eglTerminate           ( void* dpy );
+    unsigned int eglBindAPI             ( unsigned int api );
+    const char*  eglQueryString         ( void* dpy, int name );
+    unsigned int eglChooseConfig        ( void* dpy, const int* attr, void** cfg, int size, int* count );
+    void*        eglCreateContext       ( void* dpy, void* cfg, void* share, const int* attr );
+    unsigned int eglDestroyContext      ( void* dpy, void* ctx );
+    void*        eglCreatePbufferSurface( void* dpy, void* cfg, const int* attr );
+    unsigned int eglDestroySurface      ( void* dpy, void* surface );
+    unsigned int eglMakeCurrent         ( void* dpy, void* draw, void* read, void* ctx );
+}
+#else
+extern "C" {
+    void* glfwGetProcAddress    ( const char* name );
+    void  glfwMakeContextCurrent( void* window );
+}
+#endif
+
+namespace RL { namespace GL {
+
+    enum {
+        PIXEL_PACK_BUFFER    = 0x88EB, STREAM_READ       = 0x88E1,
+        READ_FRAMEBUFFER     = 0x8CA8, MAP_READ_BIT      = 0x0001,
+        PACK_ALIGNMENT       = 0x0D05, SYNC_GPU_COMMANDS = 0x9117,
+        ALREADY_SIGNALED     = 0x911A, TIMEOUT_EXPIRED   = 0x911B,
+        CONDITION_SATISFIED  = 0x911C, WAIT_FAILED       = 0x911D,
+        RGBA                 = 0x1908, FLOAT             = 0x1406,
+        VENDOR               = 0x1F00, RENDERER          = 0x1F01,
+        VERSION              = 0x1F02, LINK_STATUS       = 0x8B82,
+        PROGRAM_BINARY_LENGTH= 0x8741, NUM_PROGRAM_BINARY_FORMATS = 0x87FE,
+        MAX_TEXTURE_SIZE     = 0x0D33, SYNC_FLUSH_COMMANDS_BIT    = 0x0001,
+        POINTS               = 0x0000, FUNC_ADD          = 0x8006, ONE  = 0x0001,
+        TIME_ELAPSED         = 0x88BF, QUERY_RESULT      = 0x8866,
+        QUERY_RESULT_AVAILABLE = 0x8867,
+        MAJOR_VERSION        = 0x821B, MINOR_VERSION     = 0x821C,
+        COMPUTE_SHADER       = 0x91B9, SHADER_STORAGE_BUFFER = 0x90D2,
+        DYNAMIC_COPY         = 0x88EA, SHADER_STORAGE_BARRIER_BIT = 0x2000,
+        BUFFER_UPDATE_BARRIER_BIT = 0x0200,
+        PIXEL_UNPACK_BUFFER  = 0x88EC, STREAM_DRAW       = 0x88E0,
+        MAP_WRITE_BIT        = 0x0002, MAP_INVALIDATE_BUFFER_BIT = 0x0008,
+        UNPACK_ALIGNMENT     = 0x0CF5,
+        MAX_COMPUTE_WORK_GROUP_INVOCATIONS = 0x90EB
+    };
+
+    struct FN {
+        void  (GPU_GLAPI *GenBuffers)    ( int, unsigned int* );
+        void  (GPU_GLAPI *DeleteBuffers) ( int, const unsigned int* );
+        void  (GPU_GLAPI *BindBuffer)    ( unsigned int, unsigned int );
+        void  (GPU_GLAPI *BufferData)    ( unsigned int, ptrdiff_t, const void*, unsigned int );
+        void* (GPU_GLAPI *MapBufferRange)( unsigned int, ptrdiff_t, ptrdiff_t, unsigned int );
+        uchar (GPU_GLAPI *UnmapBuffer)   ( unsigned int );
+        void  (GPU_GLAPI *BindFramebuffer)( unsigned int, unsigned int );
+        void  (GPU_GLAPI *PixelStorei)   ( unsigned int, int );
+        void  (GPU_GLAPI *ReadPixels)    ( int, int, int, int, unsigned int, unsigned int, void* );
+        void* (GPU_GLAPI *FenceSync)     ( unsigned int, unsigned int );
+        unsigned int (GPU_GLAPI *ClientWaitSync)( void*, unsigned int, unsigned long long );
+        void  (GPU_GLAPI *DeleteSync)    ( void* );
+        void  (GPU_GLAPI *Flush)         ( void );
+        void  (GPU_GLAPI *GetIntegerv)   ( unsigned int, int* );
+        const uchar* (GPU_GLAPI *GetString)( unsigned int );
+        unsigned int (GPU_GLAPI *CreateProgram)( void );
+        void  (GPU_GLAPI *DeleteProgram) ( unsigned int );
+        void  (GPU_GLAPI *GetProgramiv)  ( unsigned int, unsigned int, int* );
+        void  (GPU_GLAPI *GetProgramBinary)( unsigned int, int, int*, unsigned int*, void* );
+        void  (GPU_GLAPI *ProgramBinary) ( unsigned int, unsigned int, const void*, int );
+        void  (GPU_GLAPI *DrawArrays)    ( unsigned int, int, int );
+        void  (GPU_GLAPI *GenQueries)    ( int, unsigned int* );
+        void  (GPU_GLAPI *DeleteQueries) ( int, const unsigned int* );
+        void  (GPU_GLAPI *BeginQuery)    ( unsigned int, unsigned int );
+        void  (GPU_GLAPI *EndQuery)      ( unsigned int );
+        void  (GPU_GLAPI *GetQueryObjectiv)( unsigned int, unsigned int, int* );
+        void  (GPU_GLAPI *GetQueryObjectui64v)( unsigned int, unsigned int, unsigned long long* );
+        void  (GPU_GLAPI *AttachShader)  ( unsigned int, unsigned int );
+        void  (GPU_GLAPI *LinkProgram)   ( unsigned int );
+        void  (GPU_GLAPI *DeleteShader)  ( unsigned int );
+        void  (GPU_GLAPI *DispatchCompute)( unsigned int, unsigned int, unsigned int );
+        void  (GPU_GLAPI *MemoryBarrier) ( unsigned int );
+        void  (GPU_GLAPI *BindBufferBase)( unsigned int, unsigned int, unsigned int );
+        void  (GPU_GLAPI *BufferSubData) ( unsigned int, ptrdiff_t, ptrdiff_t, const void* );
+        void  (GPU_GLAPI *GetBufferSubData)( unsigned int, ptrdiff_t, ptrdiff_t, void* );
+    };
+
+#ifdef GPU_HEADLESS
+    void* GetProcAddress( const char* name ){ return eglGetProcAddress( name ); }
+#else
+    void* GetProcAddress( const char* name ){ return glfwGetProcAddress( name ); }
+#endif
+
+    FN* Load() {
+        static FN fn; static bool loaded = false;
+        if( loaded ){ return &fn; } /*---------*/ loaded = true;
+
+        fn.GenBuffers     = (decltype(fn.GenBuffers))     GetProcAddress("glGenBuffers");
+        fn.DeleteBuffers  = (decltype(fn.DeleteBuffers))  GetProcAddress("glDeleteBuffers");
+        fn.BindBuffer     = (decltype(fn.BindBuffer))     GetProcAddress("glBindBuffer");
+        fn.BufferData     = (decltype(fn.BufferData))     GetProcAddress("glBufferData");
+        fn.MapBufferRange = (decltype(fn.MapBufferRange)) GetProcAddress("glMapBufferRange");
+        fn.UnmapBuffer    = (decltype(fn.UnmapBuffer))    GetProcAddress("glUnmapBuffer");
+        fn.BindFramebuffer= (decltype(fn.BindFramebuffer))GetProcAddress("glBindFramebuffer");
+        fn.PixelStorei    = (decltype(fn.PixelStorei))    GetProcAddress("glPixelStorei");
+        fn.ReadPixels     = (decltype(fn.ReadPixels))     GetProcAddress("glReadPixels");
+        fn.FenceSync      = (decltype(fn.FenceSync))      GetProcAddress("glFenceSync");
+        fn.ClientWaitSync = (decltype(fn.ClientWaitSync)) GetProcAddress("glClientWaitSync");
+        fn.DeleteSync     = (decltype(fn.DeleteSync))     GetProcAddress("glDeleteSync");
+        fn.Flush          = (decltype(fn.Flush))          GetProcAddress("glFlush");
+        fn.GetIntegerv    = (decltype(fn.GetIntegerv))    GetProcAddress("glGetIntegerv");
+        fn.GetString      = (decltype(fn.GetString))      GetProcAddress("glGetString");
+        fn.CreateProgram  = (decltype(fn.CreateProgram))  GetProcAddress("glCreateProgram");
+        fn.DeleteProgram  = (decltype(fn.DeleteProgram))  GetProcAddress("glDeleteProgram");
+        fn.GetProgramiv   = (decltype(fn.GetProgramiv))   GetProcAddress("glGetProgramiv");
+        fn.GetProgramBinary=(decltype(fn.GetProgramBinary))GetProcAddress("glGetProgramBinary");
+        fn.ProgramBinary  = (decltype(fn.ProgramBinary))  GetProcAddress("glProgramBinary");
+        fn.DrawArrays     = (decltype(fn.DrawArrays))     GetProcAddress("glDrawArrays");
+        fn.GenQueries     = (decltype(fn.GenQueries))     GetProcAddress("glGenQueries");
+        fn.DeleteQueries  = (decltype(fn.DeleteQueries))  GetProcAddress("glDeleteQueries");
+        fn.BeginQuery     = (decltype(fn.BeginQuery))     GetProcAddress("glBeginQuery");
+        fn.EndQuery       = (decltype(fn.EndQuery))       GetProcAddress("glEndQuery");
+        fn.GetQueryObjectiv=(decltype(fn.GetQueryObjectiv))GetProcAddress("glGetQueryObjectiv");
+        fn.GetQueryObjectui64v=(decltype(fn.GetQueryObjectui64v))GetProcAddress("glGetQueryObjectui64v");
+        fn.AttachShader   = (decltype(fn.AttachShader))   GetProcAddress("glAttachShader");
+        fn.LinkProgram    = (decltype(fn.LinkProgram))    GetProcAddress("glLinkProgram");
+        fn.DeleteShader   = (decltype(fn.DeleteShader))   GetProcAddress("glDeleteShader");
+        fn.DispatchCompute= (decltype(fn.DispatchCompute))GetProcAddress("glDispatchCompute");
+        fn.MemoryBarrier  = (decltype(fn.MemoryBarrier))  GetProcAddress("glMemoryBarrier");
+        fn.BindBufferBase = (decltype(fn.BindBufferBase)) GetProcAddress("glBindBufferBase");
+        fn.BufferSubData  = (decltype(fn.BufferSubData))  GetProcAddress("glBufferSubData");
+        fn.GetBufferSubData=(decltype(fn.GetBufferSubData))GetProcAddress("glGetBufferSubData");
+
+        return &fn;
+    }
+
+}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
 #ifndef GPU_KERNEL
 #define GPU_KERNEL(...) #__VA_ARGS__
 #endif
 
+#ifndef GPU_READBACK_RING
+#define GPU_READBACK_RING 3
+#endif
+
+#ifndef GPU_POOL_BUDGET
+#define GPU_POOL_BUDGET 268435456 // 256 MiB of idle textures
+#endif
+
 #if _KERNEL_ == NODEPP_KERNEL_WASM
     #define GLSL_VERSION "#version 100\nprecision mediump float;\n"
 #else 
@@ -151,79 +300,359 @@ struct  vec4_t { float  x; float  y; float  z; float  w; };
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
-namespace nodepp { namespace gpu { class matrix_t {
-protected:
+namespace nodepp { namespace gpu { bool _gpu_ = false; }}
 
-    struct NODE {
-        uint width, height;
-        ptr_t<float> data;
-    };  ptr_t<NODE>  obj;
+/*────────────────────────────────────────────────────────────────────────────*/
 
-public:
+namespace nodepp { namespace gpu { 
 
-    matrix_t( uint width, uint height, ptr_t<float> data ) : obj( new NODE() ) {
+    uint get_channels( uint format ) noexcept { switch( format ){
+        case OUT_UCHAR : case OUT_FLOAT : case OUT_DOUBLE : return 1;
+        case OUT_UCHAR2: /*--------------------------*/ return 2;
+        case OUT_UCHAR3: case OUT_FLOAT3: case OUT_DOUBLE3: return 3;
+        case OUT_UCHAR4: case OUT_FLOAT4: case OUT_DOUBLE4: return 4;
+    }   return 0; }
+
+    uint get_depth( uint format ) noexcept { switch( format ){
+        case OUT_UCHAR : case OUT_UCHAR2: case OUT_UCHAR3 : case OUT_UCHAR4 : return 1;
+        case OUT_FLOAT : case OUT_FLOAT3: case OUT_FLOAT4 : /*-----------*/ return 2;
+        case OUT_DOUBLE: case OUT_DOUBLE3: case OUT_DOUBLE4: /*---------*/ return 4;
+    }   return 0; }
+
+    uint get_max_texture_size() noexcept {
+        static int out = 0; if( out>0 ){ return out; }
+        RL::GL::Load()->GetIntegerv( RL::GL::MAX_TEXTURE_SIZE, &out );
+        if( out<=0 ){ out = 4096; } return out;
+    }
 
-        if( width * height != data.size() )
-          { throw except_t( "matrix ptr size must be", width * height ); }
+    /* PBO readback needs mapped buffers and fences (GL 3.0 / GLES 3); GL 2.1,
+       GLES 2 and WebGL 1 leave those entries null and read back synchronously */
+    bool has_readback() noexcept {
+        static int out = -1; if( out>=0 ){ return out==1; }
+        if( !_gpu_ ){ return false; } auto gl = RL::GL::Load();
+        out = gl->GenBuffers!=nullptr && gl->BindBuffer!=nullptr && gl->BufferData!=nullptr
+           && gl->MapBufferRange!=nullptr && gl->UnmapBuffer!=nullptr && gl->FenceSync!=nullptr
+           && gl->ClientWaitSync!=nullptr && gl->DeleteSync!=nullptr && gl->BindFramebuffer!=nullptr;
+        return out==1;
+    }
 
-        obj->data = ptr_t<float>( width * height * 4, 0x00 );
-        obj->width= width; obj->height = height;
+    float get_half( ushort value ) noexcept {
+        uint sign = ( value & 0x8000 ) << 16, expo = ( value >> 10 ) & 0x1f, mant = value & 0x3ff;
+        uint bits = 0; float out = 0;
 
-        ulong x=0; while( x<data.size() ){
-            ulong y=x*4;
-            obj->data[y] = data[x];
-        ++x; } 
+        if  ( expo==0x1f ){ bits = sign | 0x7f800000 | ( mant << 13 ); }
+        else if( expo!=0x00 ){ bits = sign | ( ( expo + 112 ) << 23 ) | ( mant << 13 ); }
+        else if( mant!=0x00 ){ out  = ldexp( (float) mant, -24 ); return sign ? -out : out; }
+        else /*---------*/{ bits = sign; }
 
+        memcpy( &out, &bits, sizeof(float) ); return out;
     }
 
-    matrix_t( uint width, uint height, ptr_t<vec2_t> data ) : obj( new NODE() ) {
+    /* round-to-nearest float -> binary16, used when writing OUT_FLOAT* on the CPU */
+    ushort set_half( float value ) noexcept {
+        uint bits = 0; memcpy( &bits, &value, sizeof(float) );
+        uint sign = ( bits >> 16 ) & 0x8000, mant = bits & 0x7fffff;
+        int  expo = (int)( ( bits >> 23 ) & 0xff ) - 112;
+
+        if  ( ( bits & 0x7fffffff ) > 0x7f800000 ){ return sign | 0x7e00; }
+        if  ( expo >= 0x1f ){ return sign | 0x7c00; }
+        if  ( expo <= 0x00 ){ if( expo < -10 ){ return sign; }
+              uint shift = 14 - expo; mant |= 0x800000;
+              return sign | ( ( mant + ( 1u << ( shift-1 ) ) ) >> shift );
+        }     return sign | ( ( ( expo << 10 ) | ( mant >> 13 ) ) + ( ( mant >> 12 ) & 1 ) );
+    }
 
-        if( width * height != data.size() )
-          { throw except_t( "matrix ptr size must be", width * height ); }
+}}
 
-        obj->data = ptr_t<float>( width * height * 4, 0x00 );
-        obj->width= width; obj->height = height;
+/*────────────────────────────────────────────────────────────────────────────*/
 
-        ulong x=0; while( x<data.size() ){
-        ulong y=x*4;
-            obj->data[y+0] = data[x].x;
-            obj->data[y+1] = data[x].y;
-        ++x; }
+namespace nodepp { namespace gpu { struct stats_t {
+    ulong compiles=0, draws=0, uploads=0, readbacks=0;
+    ulong compile_ns=0, draw_ns=0, upload_ns=0, readback_ns=0, convert_ns=0;
+    ulong upload_bytes=0, download_bytes=0;
+};}}
 
+namespace nodepp { namespace gpu { namespace stats {
+
+    map_t<string_t,ptr_t<stats_t>> _registry_;
+    stats_t _global_; stats_t* _current_ = nullptr;
+
+    ulong now() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch() ).count();
     }
 
-    matrix_t( uint width, uint height, ptr_t<vec3_t> data ) : obj( new NODE() ) {
+    /* charges everything measured while alive to one kernel's stats too */
+    struct scope_t {
+        stats_t* prev; scope_t( stats_t* item ) noexcept : prev( _current_ ) { _current_ = item; }
+        ~scope_t() noexcept { _current_ = prev; }
+    };
+
+    /*─······································································─*/
+
+    template< class T >
+    void add( T cb ) noexcept { cb( _global_ ); if( _current_ ){ cb( *_current_ ); } }
+
+    void add_compile ( ulong ns ) noexcept { add([&]( stats_t& x ){ x.compiles++; x.compile_ns += ns; }); }
+    void add_convert ( ulong ns ) noexcept { add([&]( stats_t& x ){ x.convert_ns += ns; }); }
+    void add_draw    ( ulong ns ) noexcept { add([&]( stats_t& x ){ x.draw_ns += ns; }); }
+    void add_dispatch() noexcept { add([&]( stats_t& x ){ x.draws++; }); }
+
+    void add_upload( ulong ns, ulong bytes ) noexcept {
+        add([&]( stats_t& x ){ x.uploads++; x.upload_ns += ns; x.upload_bytes += bytes; });
+    }
+
+    void add_readback( ulong ns, ulong bytes ) noexcept {
+        add([&]( stats_t& x ){ x.readbacks++; x.readback_ns += ns; x.download_bytes += bytes; });
+    }
+
+    /*─······································································─*/
+
+    string_t to_json( const stats_t& x ) noexcept {
+        char buff[512]; snprintf( buff, 512,
+            "{\"compiles\":%lu,\"draws\":%lu,\"uploads\":%lu,\"readbacks\":%lu,"
+            "\"compile_ns\":%lu,\"draw_ns\":%lu,\"upload_ns\":%lu,\"readback_ns\":%lu,"
+            "\"convert_ns\":%lu,\"upload_bytes\":%lu,\"download_bytes\":%lu}",
+            x.compiles, x.draws, x.uploads, x.readbacks, x.compile_ns, x.draw_ns,
+            x.upload_ns, x.readback_ns, x.convert_ns, x.upload_bytes, x.download_bytes
+        );  return buff;
+    }
+
+    /* { "global": {...}, "kernels": { "<name>": {...}, ... } } */
+    string_t to_json() noexcept {
+        string_t out = "{\"global\":" + to_json( _global_ ) + ",\"kernels\":{"; bool first=true;
+        for( auto x: _registry_.data() ){
+             if( !first ){ out += ","; } first = false;
+             out += "\"" + x.first + "\":" + to_json( *x.second );
+        }    out += "}}"; return out;
+    }
+
+    stats_t get() noexcept { return _global_; }
+
+    void reset() noexcept {
+        _global_ = stats_t(); for( auto x: _registry_.data() ){ *x.second = stats_t(); }
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace pool {
+
+    struct ITEM  { RL::RenderTexture2D target; ulong bytes; ulong stamp; };
+    struct STATS { ulong hits=0, misses=0, evictions=0, idle=0, live=0; };
+
+    map_t<string_t,array_t<ITEM>> _idle_;
+    ulong  _budget_ = GPU_POOL_BUDGET;
+    ulong  _clock_  = 0; STATS _stats_;
+
+    // while an executor owns the context, textures released on this thread
+    // are only queued here and unloaded by the thread holding the context
+    std::atomic<bool> _defer_( false );
+    std::mutex /*--*/ _lock_; array_t<ITEM> _dead_;
+
+    /*─······································································─*/
+
+    string_t get_key( bool fbo, int width, int height, int format ) noexcept {
+        char buff[48]; snprintf( buff, 48, "%c:%d:%d:%d", fbo ? 'f' : 't', width, height, format );
+        return buff;
+    }
+
+    ulong get_bytes( int width, int height, int format ) noexcept {
+        return RL::GetPixelDataSize( width, height, format );
+    }
+
+    void unload( const ITEM& item, bool now=false ) noexcept {
+        if( !_gpu_ ){ return; } if( !now && _defer_.load() ){
+            std::lock_guard<std::mutex> lock( _lock_ ); _dead_.push( item ); return;
+        }   if( item.target.id>0 )
+          { RL::UnloadRenderTexture( item.target ); }
+        else { RL::UnloadTexture( item.target.texture ); }
+    }
+
+    /* unloads what was queued while the context lived on another thread;
+       only call it from the thread that currently holds the context */
+    void collect() noexcept {
+        std::lock_guard<std::mutex> lock( _lock_ ); while( !_dead_.empty() ){
+            unload( _dead_[0], true ); _dead_.shift();
+        }
+    }
+
+    /* entry points that talk to GL directly refuse to run on this thread
+       while an executor holds the context */
+    void check_owner() {
+        if( _defer_.load() ){ throw except_t("gpu context owned by executor"); }
+    }
+
+    /* drops least recently released entries until idle memory fits */
+    void evict( ulong budget ) noexcept { while( _stats_.idle > budget ){
+        string_t key; ulong pos=0, stamp=~0UL;
+
+        for( auto& x: _idle_.data() ){ for( ulong y=0; y<x.second.size(); ++y ){
+             if( x.second[y].stamp>=stamp ){ continue; }
+             stamp = x.second[y].stamp; key = x.first; pos = y;
+        }}   if( key.empty() ){ break; }
+
+        auto& list = _idle_[ key ]; auto item = list[ pos ];
+        list[ pos ] = list[ list.size()-1 ]; list.pop();
+        if( list.empty() ){ _idle_.erase( key ); }
+
+        _stats_.idle -= item.bytes; _stats_.evictions++; unload( item );
+    }}
+
+    /* idle hit only; no GL call, so it is safe off the context thread */
+    bool take( bool fbo, int width, int height, int format, ITEM& out ) noexcept {
+        auto key = get_key( fbo, width, height, format );
+        if( !_idle_.has( key ) ){ return false; }
+
+        auto& list = _idle_[ key ]; out = list[ list.size()-1 ]; list.pop();
+        if( list.empty() ){ _idle_.erase( key ); }
+        _stats_.idle -= out.bytes; _stats_.live += out.bytes;
+        _stats_.hits++; return true;
+    }
+
+    /* GL side of a miss; the texture id stays 0 when allocation fails */
+    ITEM load( bool fbo, int width, int height, int format ) noexcept {
+        ITEM item; item.stamp = 0; item.bytes = get_bytes( width, height, format );
+        if( fbo ){ item.target = RL::LoadRenderTexture( width, height, format ); }
+        else {
+            item.target = RL::RenderTexture2D({ 0 });
+            item.target.texture.id      = RL::rlLoadTexture( nullptr, width, height, format, 1 );
+            item.target.texture.width   = width ; item.target.texture.height = height;
+            item.target.texture.format  = format; item.target.texture.mipmaps= 1;
+        }   return item;
+    }
+
+    /* books a texture loaded by load(), possibly on another thread */
+    void add_miss( const ITEM& item ) noexcept {
+        _stats_.live += item.bytes; _stats_.misses++;
+    }
+
+    ITEM get( bool fbo, int width, int height, int format ) {
+        ITEM item; if( take( fbo, width, height, format, item ) ){ return item; }
+        item = load( fbo, width, height, format );
+        if( item.target.texture.id==0 ){ throw except_t( "gpu texture allocation failed" ); }
+        add_miss( item ); return item;
+    }
+
+    void put( const RL::RenderTexture2D& target ) noexcept {
+        if( target.texture.id==0 || !_gpu_ ){ return; }
+        auto& tex = target.texture; ITEM item;
+        item.target = target; item.stamp = ++_clock_;
+        item.bytes  = get_bytes( tex.width, tex.height, tex.format );
+
+        _stats_.live -= _stats_.live>item.bytes ? item.bytes : _stats_.live;
+        _stats_.idle += item.bytes;
+
+        _idle_[ get_key( target.id>0, tex.width, tex.height, tex.format ) ].push( item );
+        evict( _budget_ );
+    }
+
+    /*─······································································─*/
+
+    RL::RenderTexture2D get_target( int width, int height, int format ) {
+        return get( true, width, height, format ).target;
+    }
+
+    RL::Texture2D get_texture( int width, int height, int format ) {
+        return get( false, width, height, format ).target.texture;
+    }
+
+    void put_target ( const RL::RenderTexture2D& target ) noexcept { put( target ); }
+
+    void put_texture( const RL::Texture2D& texture ) noexcept {
+        RL::RenderTexture2D target = { 0 }; target.texture = texture; put( target );
+    }
+
+    /*─······································································─*/
+
+    void  set_budget( ulong bytes ) noexcept { _budget_ = bytes; evict( _budget_ ); }
+    ulong get_budget() noexcept { return _budget_; }
+    STATS get_stats () noexcept { return _stats_; }
+
+    void clear() noexcept { evict( 0 ); _idle_.clear(); }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class executor_t; class matrix_t {
+protected: friend class executor_t;
+
+    struct NODE {
+        uint width=0, height=0, format=OUT_DOUBLE4;
+        ptr_t<uchar> data;
+        RL::Texture2D texture = { 0 };
+        bool /*---*/ dirty  = 1;
+    };  ptr_t<NODE>  obj;
+
+    template< class T >
+    void set_data( uint width, uint height, uint format, const ptr_t<T>& data ) {
 
         if( width * height != data.size() )
           { throw except_t( "matrix ptr size must be", width * height ); }
 
-        obj->data = ptr_t<float>( width * height * 4, 0x00 );
-        obj->width= width; obj->height = height;
+        obj->width = width; obj->height = height; obj->format = format;
+        obj->data  = ptr_t<uchar>( width * height * get_channels( format ) * get_depth( format ), 0x00 );
+
+        ulong step = get_channels( format ) * sizeof(float);
+        if( step == sizeof(T) ){ memcpy( &obj->data, &data, obj->data.size() ); return; }
 
         ulong x=0; while( x<data.size() ){
-        ulong y=x*4;
-            obj->data[y+0] = data[x].x;
-            obj->data[y+1] = data[x].y;
-            obj->data[y+2] = data[x].z;
+            memcpy( &obj->data + x*step, &data[x], sizeof(T) );
         ++x; }
 
     }
 
+    void set_image( const RL::Image& input ) {
+        if( !RL::IsImageValid( input ) ){ throw except_t( "invalid image" ); }
+
+        if( get_channels( input.format )==0 ){ // packed or compressed: expand to 8-bit
+            auto time = stats::now(); auto img = RL::ImageCopy( input );
+            RL::ImageFormat( &img, OUT_UCHAR4 ); stats::add_convert( stats::now() - time );
+            set_image( img ); RL::UnloadImage( img ); return;
+        }
+
+        auto time  = stats::now();
+        obj->width = input.width; obj->height = input.height; obj->format = input.format;
+        obj->data  = ptr_t<uchar>( RL::GetPixelDataSize( input.width, input.height, input.format ), 0x00 );
+        memcpy( &obj->data, input.data, obj->data.size() ); obj->dirty = 1;
+        stats::add_convert( stats::now() - time );
+    }
+
+public:
+
+    matrix_t( uint width, uint height, ptr_t<float> data ) : obj( new NODE() ) {
+        set_data( width, height, OUT_DOUBLE , data );
+    }
+
+    matrix_t( uint width, uint height, ptr_t<vec2_t> data ) : obj( new NODE() ) {
+        set_data( width, height, OUT_DOUBLE3, data ); // no RG32F pixel format in raylib
+    }
+
+    matrix_t( uint width, uint height, ptr_t<vec3_t> data ) : obj( new NODE() ) {
+        set_data( width, height, OUT_DOUBLE3, data );
+    }
+
     matrix_t( uint width, uint height, ptr_t<vec4_t> data ) : obj( new NODE() ) {
+        set_data( width, height, OUT_DOUBLE4, data );
+    }
 
-        if( width * height != data.size() )
-          { throw except_t( "matrix ptr size must be", width * height ); }
+    matrix_t( uint width, uint height, uint format ) : obj( new NODE() ) {
+        if( get_channels( format )==0 ){ throw except_t( "invalid matrix format" ); }
+        obj->width = width; obj->height = height; obj->format = format;
+        obj->data  = ptr_t<uchar>( (ulong) width * height * get_channels( format ) * get_depth( format ), 0x00 );
+    }
 
-        obj->data = ptr_t<float>( width * height * 4, 0x00 );
-        obj->width= width; obj->height = height;
+    matrix_t( uint width, uint height, ptr_t<uchar> data, uint format ) : obj( new NODE() ) {
 
-        ulong x=0; while( x<data.size() ){
-        ulong y=x*4;
-            obj->data[y+0] = data[x].x;
-            obj->data[y+1] = data[x].y;
-            obj->data[y+2] = data[x].z;
-            obj->data[y+3] = data[x].w;
-        ++x; } 
+        if( get_channels( format )==0 )
+          { throw except_t( "invalid matrix format" ); }
+        if( (ulong) width * height * get_channels( format ) * get_depth( format ) != data.size() )
+          { throw except_t( "matrix ptr size must be", width * height * get_channels( format ) * get_depth( format ) ); }
+
+        obj->width = width; obj->height = height;
+        obj->format= format;obj->data   = data  ;
 
     }
 
@@ -234,77 +663,118 @@ public:
         if( ext[0]!='.' ){ ext.unshift('.'); }
 
         auto img=RL::LoadImageFromMemory( ext.get(), (uchar*)data.get(), data.size() );
-        /*-----*/RL::ImageFormat( &img, OUT_DOUBLE4 );
-
-        obj->data = ptr_t<float>( img.width * img.height * 4, 0x00 );
-        obj->width= img.width; obj->height = img.height ;
-        memcpy( &obj->data, img.data, obj->data.size()*sizeof(float) );
-
-        RL::UnloadImage( img );
+        set_image( img ); RL::UnloadImage( img );
     }
 
     matrix_t( string_t path ) : obj( new NODE() ) {
         if( path.empty() || !fs::exists_file(path) ){ throw except_t( "invalid image" ); }
 
-        auto img=RL::LoadImage  ( path.get() );
-        /*-----*/RL::ImageFormat( &img, OUT_DOUBLE4 );
-
-        obj->data = ptr_t<float>( img.width * img.height * 4, 0x00 );
-        obj->width= img.width; obj->height = img.height ;
-        memcpy( &obj->data, img.data, obj->data.size()*sizeof(float) );
-
-        RL::UnloadImage( img );
+        auto img=RL::LoadImage( path.get() );
+        set_image( img ); RL::UnloadImage( img );
     }
 
     matrix_t( RL::Texture2D input ) : obj( new NODE() ){
         if( !RL::IsTextureValid( input ) ){ throw except_t( "invalid texture" ); }
 
-        auto img=RL::LoadImageFromTexture( input );
-        /*-----*/RL::ImageFormat( &img, OUT_DOUBLE4 );
+        auto time= stats::now(); auto img=RL::LoadImageFromTexture( input );
+        stats::add_readback( stats::now() - time, RL::GetPixelDataSize( img.width, img.height, img.format ) );
+        set_image( img ); RL::UnloadImage( img );
+    }
+
+    matrix_t( RL::Image input ) : obj( new NODE() ){ set_image( input ); }
 
-        obj->data = ptr_t<float>( img.width * img.height * 4, 0x00 );
-        obj->width= img.width; obj->height = img.height ;
-        memcpy( &obj->data, img.data, obj->data.size()*sizeof(float) );
+    /*─······································································─*/
+
+    matrix_t() noexcept : obj( new NODE() ){}
+    virtual ~matrix_t() noexcept { if( obj.count()>1 ){ return; } free(); }
 
-        RL::UnloadImage( img );
+    /*─······································································─*/
+
+    float& operator[]( ulong pos ) const {
+        if( get_depth( obj->format )!=sizeof(float) )
+          { throw except_t( "matrix is not float typed" ); }
+        obj->dirty=1; return ((float*)&obj->data)[pos];
     }
 
-    matrix_t( RL::Image input ) : obj( new NODE() ){
-        if( !RL::IsImageValid( input ) ){ throw except_t( "invalid image" ); }
-        /**/ RL::ImageFormat( &input, OUT_DOUBLE4 );
+    uint   format  () const noexcept { return obj->format; }
+    uint   channels() const noexcept { return get_channels( obj->format ); }
+    uint   depth   () const noexcept { return get_depth   ( obj->format ); }
+    ulong  size    () const noexcept { return (ulong) obj->width * obj->height * channels(); }
+    uint   height  () const noexcept { return obj->height; }
+    uint   width   () const noexcept { return obj->width;  }
 
-        obj->data = ptr_t<float>( input.width * input.height * 4, 0x00 );
-        obj->width= input.width; obj->height = input.height;
-        memcpy( &obj->data, input.data, obj->data.size()*sizeof(float) );
+    ptr_t<uchar> raw() const noexcept { obj->dirty=1; return obj->data; }
 
+    /* a normalized float copy in the native channel layout; writes to it
+       never reach the matrix, use raw() or operator[] for that */
+    ptr_t<float> to_float() const noexcept {
+        ptr_t<float> out( size(), 0x00 ); auto raw = &obj->data; auto time = stats::now();
+
+        switch( depth() ){
+            case 1: for( ulong x=0; x<out.size(); ++x ){ out[x] = raw[x] / 255.0f; } break;
+            case 2: for( ulong x=0; x<out.size(); ++x ){ out[x] = get_half( ((ushort*)raw)[x] ); } break;
+            case 4: memcpy( &out, raw, out.size()*sizeof(float) ); /*-----------------------*/ break;
+        }
+
+        stats::add_convert( stats::now() - time ); return out;
     }
 
-    /*─······································································─*/
+    matrix_t slice( uint x, uint y, uint w, uint h ) const {
+        if( x+w > obj->width || y+h > obj->height ){ throw except_t( "invalid matrix slice" ); }
 
-    matrix_t() noexcept : obj( new NODE() ){}
-    virtual ~matrix_t() { /*-------------*/ }
+        ulong step = channels() * depth(); matrix_t out;
+        out.obj->width = w; out.obj->height = h; out.obj->format = obj->format;
+        out.obj->data  = ptr_t<uchar>( (ulong) w * h * step, 0x00 );
 
-    /*─······································································─*/
+        for( ulong row=0; row<h; ++row ){
+             memcpy( &out.obj->data + row * w * step,
+                     &obj->data + ( ( y + row ) * obj->width + x ) * step, w * step );
+        }    return out;
+    }
 
-    float& operator[]( ulong pos ) const noexcept { return obj->data[pos]; }
+    matrix_t& paste( const matrix_t& input, uint x, uint y, uint w, uint h ) {
+        if( input.format()!=obj->format ){ throw except_t( "invalid matrix format" ); }
+        if( x+w > obj->width || y+h > obj->height || w > input.width() || h > input.height() )
+          { throw except_t( "invalid matrix slice" ); }
 
-    uint       size  () const noexcept { return obj->data.size(); }
-    uint       height() const noexcept { return obj->height; }
-    uint       width () const noexcept { return obj->width;  }
-    ptr_t<float> data() const noexcept { return obj->data;   }
+        ulong step = channels() * depth(); obj->dirty = 1;
+        for( ulong row=0; row<h; ++row ){
+             memcpy( &obj->data + ( ( y + row ) * obj->width + x ) * step,
+                     &input.obj->data + row * input.width() * step, w * step );
+        }    return *this;
+    }
 
     /*─······································································─*/
 
-    RL::Texture2D get() const noexcept {
-        
+    RL::Image get_image() const noexcept {
         RL::Image img; img.mipmaps=1;
         img.height = obj->height    ;
         img.width  = obj->width     ;
         img.data   = &obj->data     ;
-        img.format = OUT_DOUBLE4    ;
+        img.format = obj->format    ;
+        return img;
+    }
+
+    /*─······································································─*/
+
+    void free() const noexcept { if( obj->texture.id!=0 ){
+        pool::put_texture( obj->texture );
+        obj->texture.id = 0; obj->dirty = 1;
+    }}
+
+    /*─······································································─*/
 
-        return RL::LoadTextureFromImage( img );
+    RL::Texture2D get() const {
+        if( obj->texture.id!=0 && !obj->dirty ){ return obj->texture; }
+        pool::check_owner(); /*-------------------------------------*/
 
+        auto time = stats::now(); if( obj->texture.id==0 ){
+            auto img = get_image(); /*--------------------------------------*/
+            obj->texture = pool::get_texture( img.width, img.height, img.format );
+        }   RL::UpdateTexture( obj->texture, &obj->data );
+        stats::add_upload( stats::now() - time, obj->data.size() );
+
+        obj->dirty = 0; return obj->texture;
     }
 
 };}}
@@ -336,48 +806,306 @@ template<> struct gpu_type_id<uvec4_t>  { static constexpr uchar value = 0x33; }
 template<> struct gpu_type_id< vec4_t>  { static constexpr uchar value = 0x34; };
 
 template<> struct gpu_type_id<matrix_t> { static constexpr uchar value = 0x50; };
+template<> struct gpu_type_id<RL::Texture2D> { static constexpr uchar value = 0x51; };
+
+}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu {
+
+    /* GLSL type of a gpu_type_id, nullptr when it has none */
+    const char* get_uniform_type( uchar type ) noexcept { switch( type ){
+
+        case 0x01: return "bool" ; case 0x02: return "int"  ;
+        case 0x03: return "uint" ; case 0x04: return "float";
+
+        case 0x11: return "bvec2"; case 0x12: return "ivec2";
+        case 0x13: return "uvec2"; case 0x14: return "vec2" ;
+
+        case 0x21: return "bvec3"; case 0x22: return "ivec3";
+        case 0x23: return "uvec3"; case 0x24: return "vec3" ;
+
+        case 0x31: return "bvec4"; case 0x32: return "ivec4";
+        case 0x33: return "uvec4"; case 0x34: return "vec4" ;
+
+        case 0x50: return "sampler2D"; case 0x51: return "sampler2D";
+
+    default: return nullptr; }}
+
+    template< class T >
+    int get_uniform( const any_t& value, int flag, const void*& data, ulong& size ) noexcept {
+        data = &(*value.as<ptr_t<T>>()); size = sizeof(T); return flag;
+    }
+
+    /* GL uniform flag of a stored input, pointing `data` at its value;
+       samplers give -1, they bind a texture unit instead */
+    int get_uniform( uchar type, const any_t& value, const void*& data, ulong& size ) noexcept { switch( type ){
+
+        case 0x01: return get_uniform<bool>   ( value, VAR_BOOL , data, size );
+        case 0x02: return get_uniform<int>    ( value, VAR_INT  , data, size );
+        case 0x03: return get_uniform<uint>   ( value, VAR_UINT , data, size );
+        case 0x04: return get_uniform<float>  ( value, VAR_FLOAT, data, size );
+
+        case 0x11: return get_uniform<bvec2_t>( value, VAR_BVEC2, data, size );
+        case 0x12: return get_uniform<ivec2_t>( value, VAR_IVEC2, data, size );
+        case 0x13: return get_uniform<uvec2_t>( value, VAR_UVEC2, data, size );
+        case 0x14: return get_uniform< vec2_t>( value, VAR_VEC2 , data, size );
+
+        case 0x21: return get_uniform<bvec3_t>( value, VAR_BVEC3, data, size );
+        case 0x22: return get_uniform<ivec3_t>( value, VAR_IVEC3, data, size );
+        case 0x23: return get_uniform<uvec3_t>( value, VAR_UVEC3, data, size );
+        case 0x24: return get_uniform< vec3_t>( value, VAR_VEC3 , data, size );
+
+        case 0x31: return get_uniform<bvec4_t>( value, VAR_BVEC4, data, size );
+        case 0x32: return get_uniform<ivec4_t>( value, VAR_IVEC4, data, size );
+        case 0x33: return get_uniform<uvec4_t>( value, VAR_UVEC4, data, size );
+        case 0x34: return get_uniform< vec4_t>( value, VAR_VEC4 , data, size );
+
+    default: return -1; }}
 
 }}
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
 namespace nodepp { namespace gpu { string_t _kernel_=GPU_KERNEL( 
-    ${0} ${1} vec4 init(){
-        vec2 uv=gl_FragCoord.xy; ${2}
-    } void main(){ gl_FragColor = init(); });
+    ${0} ${1} ${2} ${3} vec4 init(){
+        vec2 uv=gl_FragCoord.xy; ${4} ${5}
+    } void main(){ ${6} });
 }}
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
-namespace nodepp { namespace gpu { class gpu_t {
-protected:
+namespace nodepp { namespace gpu { namespace cache {
+
+    map_t<string_t,ptr_t<RL::Shader>> _programs_;
+    map_t<uint,void*> /*-----------*/ _owner_;
+    string_t /*------------------*/ _path_;
+    ulong /*------------*/ _generation_=0; // bumped by clear()
+
+    string_t hash( string_t data ) noexcept {
+        unsigned long long out = 14695981039346656037ULL; for( auto x: data ){
+              out = ( out ^ (uchar) x ) * 1099511628211ULL;
+        }     char buff[17]; snprintf( buff, 17, "%016llx", out );
+        return buff;
+    }
+
+    string_t get_driver() noexcept {
+        auto gl = RL::GL::Load(); string_t out;
+        for( auto x: { RL::GL::VENDOR, RL::GL::RENDERER, RL::GL::VERSION } ){
+             auto str = gl->GetString( x ); if( str==nullptr ){ continue; }
+             out += string_t( (char*) str ); out += "\n";
+        }    return out;
+    }
+
+    /*─······································································─*/
+
+    RL::Shader get_shader( uint id ) noexcept {
+        RL::Shader out; out.id = id;
+        out.locs = (int*) RL_CALLOC( RL_MAX_SHADER_LOCATIONS, sizeof(int) );
+        for( int x=0; x<RL_MAX_SHADER_LOCATIONS; ++x ){ out.locs[x] = -1; }
+
+        out.locs[RL::SHADER_LOC_VERTEX_POSITION]   = RL::rlGetLocationAttrib ( id, "vertexPosition" );
+        out.locs[RL::SHADER_LOC_VERTEX_TEXCOORD01] = RL::rlGetLocationAttrib ( id, "vertexTexCoord" );
+        out.locs[RL::SHADER_LOC_VERTEX_COLOR]      = RL::rlGetLocationAttrib ( id, "vertexColor"    );
+        out.locs[RL::SHADER_LOC_MATRIX_MVP]        = RL::rlGetLocationUniform( id, "mvp"            );
+        out.locs[RL::SHADER_LOC_COLOR_DIFFUSE]     = RL::rlGetLocationUniform( id, "colDiffuse"     );
+        out.locs[RL::SHADER_LOC_MAP_ALBEDO]        = RL::rlGetLocationUniform( id, "texture0"       );
+
+        return out;
+    }
+
+    ptr_t<RL::Shader> load_binary( string_t path ) noexcept {
+        if( !fs::exists_file( path ) ){ return ptr_t<RL::Shader>(); }
+
+        auto gl   = RL::GL::Load(); int status=0;
+        auto data = fs::read_file( path ); if( data.size()<=sizeof(uint) ){ return ptr_t<RL::Shader>(); }
+        uint type = 0; memcpy( &type, data.get(), sizeof(uint) );
+
+        auto id = gl->CreateProgram();
+        gl->ProgramBinary( id, type, data.get()+sizeof(uint), data.size()-sizeof(uint) );
+        gl->GetProgramiv ( id, RL::GL::LINK_STATUS, &status );
+
+        if( status==0 ){ // driver rejected the binary: rebuild from source
+            gl->DeleteProgram( id ); fs::remove_file( path ); return ptr_t<RL::Shader>();
+        }   return type::bind( get_shader( id ) );
+    }
+
+    void save_binary( string_t path, const RL::Shader& shader ) noexcept {
+        auto gl = RL::GL::Load(); int size=0; uint type=0;
+        gl->GetProgramiv( shader.id, RL::GL::PROGRAM_BINARY_LENGTH, &size );
+        if( size<=0 ){ return; }
+
+        string_t data( size+sizeof(uint), '\0' );
+        gl->GetProgramBinary( shader.id, size, &size, &type, data.get()+sizeof(uint) );
+        memcpy( data.get(), &type, sizeof(uint) ); if( size<=0 ){ return; }
+
+        fs::write_file( path, data );
+    }
+
+    bool has_binary_support() noexcept {
+        auto gl = RL::GL::Load(); int count=0;
+        if( gl->ProgramBinary==nullptr || gl->GetProgramBinary==nullptr ){ return false; }
+        gl->GetIntegerv( RL::GL::NUM_PROGRAM_BINARY_FORMATS, &count ); return count>0;
+    }
+
+    /*─······································································─*/
+
+    void set_path( string_t path ) {
+        if( !path.empty() && !fs::exists_folder( path ) ){ fs::create_folder( path ); }
+        _path_ = path;
+    }
+
+    string_t get_path() noexcept { return _path_; }
+
+    /* lookup only, no GL call */
+    ptr_t<RL::Shader> find( string_t source ) noexcept {
+        auto key = hash( source ); if( !_programs_.has( key ) ){ return ptr_t<RL::Shader>(); }
+        return _programs_[ key ];
+    }
+
+    /* adopts a program linked on another thread, e.g. an executor's */
+    ptr_t<RL::Shader> set( string_t source, const RL::Shader& shader ) noexcept {
+        auto out = type::bind( shader ); _programs_[ hash( source ) ] = out; return out;
+    }
+
+    /* fragment source, optionally paired with a custom vertex stage */
+    ptr_t<RL::Shader> get( string_t source, string_t vertex="" ) {
+        string_t code = vertex.empty() ? source : vertex + source;
+        auto key = hash( code );
+        if( _programs_.has( key ) ){ return _programs_[ key ]; }
+
+        ptr_t<RL::Shader> out; string_t path;
+
+        if( !_path_.empty() && has_binary_support() ){
+            path = regex::format( "${0}/${1}.bin", _path_,
+                   hash( code + GLSL_VERSION + get_driver() ) );
+            out  = load_binary( path );
+        }
+
+        if( out.null() ){
+            out = type::bind( RL::LoadShaderFromMemory(
+                  vertex.empty() ? nullptr : vertex.get(), source.get()
+            ));
+            if( !RL::IsShaderValid( *out ) ){ throw except_t("Invalid Shader"); }
+            if( !path.empty() ){ save_binary( path, *out ); }
+        }
+
+        _programs_[ key ] = out; return out;
+    }
+
+    void clear() noexcept {
+        for( auto x: _programs_.data() ){ if( _gpu_ ){ RL::UnloadShader( *x.second ); }}
+        _programs_.clear(); _owner_.clear(); ++_generation_;
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { string_t _tile_=GPU_KERNEL(
+    vec4 gpu_tile_texture_${0}( vec2 c ){ return texture( ${0}, ( c - ${0}_tile.xy ) * ${0}_tile.zw ); }
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class executor_t; class cpu_t; class batch_t; class stream_t; class gpu_t {
+protected: friend class executor_t; friend class cpu_t; friend class batch_t; friend class stream_t; friend class pipeline_t;
+
+    struct SLOT { int loc=-2; ulong bound=0; };
+    struct CALL { string_t fn, name, wrapper; };
+    struct DONE { any_t value; uchar type; ulong version; ptr_t<SLOT> slot; };
 
-    struct DONE { any_t value; uchar type; };
+    /* without has_readback() the pixels land in `image` right away */
+    struct PBO {
+        unsigned int id=0; ulong size=0;
+        void* fence=nullptr; bool busy=0;
+        int width=0, height=0, format=0;
+        RL::Image image = { 0 };
+    };
+
+    struct OUTPUT { string_t name; uint format; RL::Texture2D texture; };
 
     struct NODE {
+        array_t<ptr_t<PBO>> /*-----*/ ring;
+        array_t<OUTPUT> /*------*/ outputs;
         ptr_t<RL::RenderTexture2D> texture;
         map_t<string_t,DONE> /*----*/ vars;
         ptr_t<RL::Shader> /*-----*/ shader;
         string_t /*--------------*/ kernel;
+        string_t /*-------------*/ library;
+        string_t /*------------*/ wrappers;
+        array_t<CALL> /*------------*/ calls;
+        string_t /*-------------*/ prelude;
+        map_t<string_t,string_t> constants;
+        ptr_t<stats_t> stats=ptr_t<stats_t>( new stats_t() );
+        ptr_t<function_t<matrix_t,gpu_t&>> fallback;
+        uint query=0; bool pending=0; /*-------*/
+        uint width=0, height=0, format=OUT_DOUBLE4;
+        uint tile =0, halo  =0; /*-------------*/
+        ulong /*--------*/ version=0, generation=0;
         bool /*-----------------*/ state=1;
     };  ptr_t<NODE> obj;
 
+    /* `fn( name, ... )` becomes `wrapper( ... )`; GLSL ES 1.00 has no
+       token pasting, so per-sampler redirects are spelled out here */
+    static string_t get_calls( const string_t& source, const array_t<CALL>& calls ) {
+        if( calls.empty() ){ return source; } string_t out; ulong i=0, last=0, n=source.size();
+        auto is_id = []( char c ){ return c=='_' || ( c>='0' && c<='9' ) || ( c>='a' && c<='z' ) || ( c>='A' && c<='Z' ); };
+        auto skip  = [&]( ulong j ){ while( j<n && ( source[j]==' ' || source[j]=='\t' || source[j]=='\n' || source[j]=='\r' ) ){ ++j; } return j; };
+
+        while( i<n ){
+            if( !is_id( source[i] ) ){ ++i; continue; }
+            ulong b=i; while( i<n && is_id( source[i] ) ){ ++i; }
+            string_t word = source.slice( b, i );
+
+            for( auto& x: calls ){ if( word!=x.fn ){ continue; }
+                 ulong j = skip( i ); if( j>=n || source[j]!='(' ){ break; }
+                 ulong k = skip( j+1 ), e=k; while( e<n && is_id( source[e] ) ){ ++e; }
+                 if( source.slice( k, e )!=x.name ){ continue; }
+                 ulong m = skip( e ); if( m>=n || ( source[m]!=',' && source[m]!=')' ) ){ continue; }
+                 out += source.slice( last, b ) + x.wrapper + "(";
+                 last = source[m]==',' ? m+1 : m; i = last; break;
+            }
+        }   return out + source.slice( last );
+    }
+
     string_t get_kernel_soruce() const {
         if ( obj->kernel.empty() ){ throw except_t( "not kernel found" ); }
         /**/ return obj->kernel; /*------------------------------------*/
     }
 
+    /* the full fragment source; building it makes no GL call */
+    string_t get_program() const {
+        return regex::format( _kernel_, GLSL_VERSION,
+            get_kernel_constants(), /*------*/
+            get_kernel_variables(), /*------*/
+            obj->wrappers + get_calls( obj->library, obj->calls ),
+            obj->prelude, /*----------------*/
+            get_calls( get_kernel_soruce(), obj->calls ),
+            get_kernel_outputs() /*---------*/
+        );
+    }
+
+    void set_program( const ptr_t<RL::Shader>& shader ) const noexcept {
+        obj->shader = shader; cache::_owner_[ shader->id ] = &(*obj); reset_locations();
+        obj->generation = cache::_generation_;
+    }
+
+    /* programs linked before a cache::clear() have been unloaded */
+    bool is_stale() const noexcept {
+        return obj->shader.null() || obj->generation!=cache::_generation_;
+    }
+
     /*─······································································─*/
 
-    void set_matrix( string_t name, const ptr_t<matrix_t>& value ) const noexcept {
-         int sid = RL::GetShaderLocation( *obj->shader, name.get() );
-         SetShaderValueTexture( *obj->shader, sid, value->get() );        
+    int get_location( const string_t& name, const DONE& item ) const noexcept {
+        if( item.slot->loc==-2 ){ item.slot->loc = RL::rlGetLocationUniform( obj->shader->id, name.get() ); }
+        return item.slot->loc;
     }
 
-    template< class T >
-    void set_variable( string_t name, int flag, const T& value ) const noexcept {
-         int sid = RL::GetShaderLocation( *obj->shader, name.get() );
-         SetShaderValueV( *obj->shader, sid, &value, flag, 1 );
+    void reset_locations() const noexcept {
+        for( auto x: obj->vars.data() ){ x.second.slot->loc=-2; x.second.slot->bound=0; }
     }
 
     /*─······································································─*/
@@ -385,60 +1113,293 @@ protected:
     void set_kernel_variables() const {
      if( obj->shader.null() ) /*----------*/ { throw except_t("invalid shader"); }
      if( !RL::IsShaderValid( *obj->shader ) ){ throw except_t("Invalid Shader"); }
-    for( auto x: obj->vars.data() ){ switch( x.second.type ){
 
-        case 0x01: set_variable( x.first, VAR_BOOL , x.second.value.as<ptr_t<bool>> ());   break;
-        case 0x02: set_variable( x.first, VAR_INT  , x.second.value.as<ptr_t<int>>  ());   break;
-        case 0x03: set_variable( x.first, VAR_UINT , x.second.value.as<ptr_t<uint>> ());   break;
-        case 0x04: set_variable( x.first, VAR_FLOAT, x.second.value.as<ptr_t<float>>());   break;
+     // programs are shared through the cache, so uniforms are only
+     // trusted while this kernel node was the last one to write them
+     void* self = &(*obj); if( cache::_owner_[ obj->shader->id ]!=self ){
+         cache::_owner_[ obj->shader->id ] = self; reset_locations();
+     }   RL::rlEnableShader( obj->shader->id );
+
+    for( auto x: obj->vars.data() ){ auto& y = x.second;
+         if( get_location( x.first, y )<0 ) /**/ { continue; }
+         if( y.type<0x50 && y.slot->bound==y.version ){ continue; }
+         y.slot->bound = y.version; const void* data=nullptr; ulong size=0;
+
+         int flag = get_uniform( y.type, y.value, data, size ); if( flag>=0 )
+           { RL::rlSetUniform( y.slot->loc, data, flag, 1 ); continue; }
+
+         if( y.type==0x50 ){ RL::rlSetUniformSampler( y.slot->loc, y.value.as<ptr_t<matrix_t>>()->get().id ); }
+         if( y.type==0x51 ){ RL::rlSetUniformSampler( y.slot->loc, y.value.as<ptr_t<RL::Texture2D>>()->id ); }
+
+    }}
+
+    /*─······································································─*/
+
+    matrix_t run_fallback() {
+        if( obj->fallback.null() ){ throw except_t("gpu machine not started"); }
+        stats::scope_t scope( &obj->stats ); auto time = stats::now();
+        auto out = (*obj->fallback)( *this ); stats::add_dispatch();
+        stats::add_draw( stats::now() - time ); return out;
+    }
+
+    /* one timer query in flight per kernel: a draw issued while the last
+       result is still pending goes untimed instead of stalling on it */
+    void poll_query() const noexcept {
+        if( !obj->pending ){ return; } auto gl = RL::GL::Load(); int ready = 0;
+        gl->GetQueryObjectiv( obj->query, RL::GL::QUERY_RESULT_AVAILABLE, &ready );
+        if( !ready ){ return; } unsigned long long ns = 0; obj->pending = 0;
+        gl->GetQueryObjectui64v( obj->query, RL::GL::QUERY_RESULT, &ns );
+        stats::scope_t scope( &obj->stats ); stats::add_draw( ns );
+    }
+
+    bool begin_query() const noexcept {
+        auto gl = RL::GL::Load(); poll_query();
+        if( obj->pending || gl->GenQueries==nullptr || gl->GetQueryObjectui64v==nullptr ){ return false; }
+        if( obj->query==0 ){ gl->GenQueries( 1, &obj->query ); }
+        gl->BeginQuery( RL::GL::TIME_ELAPSED, obj->query ); return true;
+    }
+
+    void draw( const RL::RenderTexture2D& target ) const {
+
+        int w = target.texture.width ;
+        int h = target.texture.height;
+
+        // pooled framebuffers are shared, so extra outputs are only
+        // attached for the duration of this draw
+        ulong n = obj->outputs.size(); for( ulong x=0; x<n; ++x ){
+              RL::rlFramebufferAttach( target.id, obj->outputs[x].texture.id,
+                  RL::RL_ATTACHMENT_COLOR_CHANNEL1 + x, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+        }
+
+        stats::scope_t scope( &obj->stats ); stats::add_dispatch();
+        RL::rlDrawRenderBatchActive(); bool timed = begin_query();
 
-        case 0x11: set_variable( x.first, VAR_BVEC2, x.second.value.as<ptr_t<bvec2_t>>()); break;
-        case 0x12: set_variable( x.first, VAR_IVEC2, x.second.value.as<ptr_t<ivec2_t>>()); break;
-        case 0x13: set_variable( x.first, VAR_UVEC2, x.second.value.as<ptr_t<uvec2_t>>()); break;
-        case 0x14: set_variable( x.first, VAR_VEC2 , x.second.value.as<ptr_t<vec2_t>> ()); break;
+        RL::BeginTextureMode( target ); if( n>0 ){ RL::rlActiveDrawBuffers( n+1 ); }
+        RL::ClearBackground ( RL::BLACK );
+        RL::BeginShaderMode ( *obj->shader  ); set_kernel_variables(); /*-----*/
+        RL::DrawRectangle( 0,0, w, h, RL::WHITE ); RL::EndShaderMode();
+        if( n>0 ){ RL::rlActiveDrawBuffers( 1 ); } RL::EndTextureMode();
+        if( timed ){ RL::GL::Load()->EndQuery( RL::GL::TIME_ELAPSED ); obj->pending = 1; }
+
+        for( ulong x=0; x<n; ++x ){
+             RL::rlFramebufferAttach( target.id, 0,
+                 RL::RL_ATTACHMENT_COLOR_CHANNEL1 + x, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+        }
+
+    }
+
+    /* ring bookkeeping only; set_readback_size() sizes the buffer store */
+    ptr_t<PBO> get_ring_slot() const noexcept {
+        while( obj->ring.size() < GPU_READBACK_RING )
+             { obj->ring.push( ptr_t<PBO>( new PBO() ) ); }
+
+        ptr_t<PBO> slot; for( auto x: obj->ring ){
+             if( !x->busy ){ slot = x; break; }
+        }    if( slot.null() ){ slot = ptr_t<PBO>( new PBO() ); obj->ring.push( slot ); }
+
+        slot->busy = 1; return slot;
+    }
+
+    static void set_readback_size( PBO& slot, ulong size ) noexcept {
+        auto gl = RL::GL::Load();
+        if( slot.id==0 ){ gl->GenBuffers( 1, &slot.id ); }
+        if( slot.size!=size ){
+            gl->BindBuffer( RL::GL::PIXEL_PACK_BUFFER, slot.id );
+            gl->BufferData( RL::GL::PIXEL_PACK_BUFFER, size, nullptr, RL::GL::STREAM_READ );
+            gl->BindBuffer( RL::GL::PIXEL_PACK_BUFFER, 0 ); slot.size = size;
+        }
+    }
+
+    /* queues the copy of `target` into the slot's PBO behind a fence */
+    static void set_readback( PBO& slot, const RL::RenderTexture2D& target ) noexcept {
+        auto gl   = RL::GL::Load();
+        int  w    = target.texture.width ;
+        int  h    = target.texture.height;
+        int  f    = target.texture.format;
+
+        slot.width = w; slot.height = h; slot.format = f; if( !has_readback() ){
+             slot.image = RL::LoadImageFromTexture( target.texture );
+             slot.size  = RL::GetPixelDataSize( w, h, f ); return;
+        }
+
+        uint glInternal, glFormat, glType;
+        RL::rlGetGlTextureFormats( f, &glInternal, &glFormat, &glType );
+        set_readback_size( slot, RL::GetPixelDataSize( w, h, f ) );
+
+        gl->BindFramebuffer( RL::GL::READ_FRAMEBUFFER, target.id );
+        gl->BindBuffer     ( RL::GL::PIXEL_PACK_BUFFER, slot.id );
+        gl->PixelStorei    ( RL::GL::PACK_ALIGNMENT, 1 );
+        gl->ReadPixels     ( 0, 0, w, h, glFormat, glType, nullptr );
+        gl->BindBuffer     ( RL::GL::PIXEL_PACK_BUFFER, 0 );
+        gl->BindFramebuffer( RL::GL::READ_FRAMEBUFFER, 0 );
+
+        slot.fence = gl->FenceSync( RL::GL::SYNC_GPU_COMMANDS, 0 ); gl->Flush();
+    }
 
-        case 0x21: set_variable( x.first, VAR_BVEC3, x.second.value.as<ptr_t<bvec3_t>>()); break;
-        case 0x22: set_variable( x.first, VAR_IVEC3, x.second.value.as<ptr_t<ivec3_t>>()); break;
-        case 0x23: set_variable( x.first, VAR_UVEC3, x.second.value.as<ptr_t<uvec3_t>>()); break;
-        case 0x24: set_variable( x.first, VAR_VEC3 , x.second.value.as<ptr_t<vec3_t>> ()); break;
+    /* drops a pending readback without collecting it */
+    static void clear_readback( PBO& slot ) noexcept {
+        if( slot.fence!=nullptr ){ RL::GL::Load()->DeleteSync( slot.fence ); slot.fence = nullptr; }
+        if( slot.image.data!=nullptr ){ RL::UnloadImage( slot.image ); slot.image.data = nullptr; }
+        slot.busy = 0;
+    }
+
+    ptr_t<PBO> get_readback_slot( ulong size ) const {
+        auto slot = get_ring_slot(); if( has_readback() ){ set_readback_size( *slot, size ); } return slot;
+    }
+
+    ptr_t<PBO> issue_readback( const RL::RenderTexture2D& target ) const {
+        auto slot = get_ring_slot(); set_readback( *slot, target ); return slot;
+    }
+
+    matrix_t finish_readback( const ptr_t<PBO>& slot ) const {
+        auto gl = RL::GL::Load(); stats::scope_t scope( &obj->stats ); auto time = stats::now();
 
-        case 0x31: set_variable( x.first, VAR_BVEC4, x.second.value.as<ptr_t<bvec4_t>>()); break;
-        case 0x32: set_variable( x.first, VAR_IVEC4, x.second.value.as<ptr_t<ivec4_t>>()); break;
-        case 0x33: set_variable( x.first, VAR_UVEC4, x.second.value.as<ptr_t<uvec4_t>>()); break;
-        case 0x34: set_variable( x.first, VAR_VEC4 , x.second.value.as<ptr_t<vec4_t>> ()); break;
+        if( slot->image.data!=nullptr ){ matrix_t out( slot->image ); clear_readback( *slot );
+            stats::add_readback( stats::now() - time, slot->size ); return out;
+        }
 
-        case 0x50: set_matrix  ( x.first, x.second.value.as<ptr_t<matrix_t>>() ); /*----*/ break;
+        if( slot->fence!=nullptr ){ gl->DeleteSync( slot->fence ); slot->fence = nullptr; }
 
-    }}}
+        gl->BindBuffer( RL::GL::PIXEL_PACK_BUFFER, slot->id );
+        auto data = gl->MapBufferRange( RL::GL::PIXEL_PACK_BUFFER, 0, slot->size, RL::GL::MAP_READ_BIT );
+
+        RL::Image img; img.mipmaps=1; img.data = data;
+        img.width = slot->width; img.height = slot->height; img.format = slot->format;
+
+        stats::add_readback( stats::now() - time, slot->size );
+        matrix_t out; if( data!=nullptr ){ out = matrix_t( img ); }
+        gl->UnmapBuffer( RL::GL::PIXEL_PACK_BUFFER );
+        gl->BindBuffer ( RL::GL::PIXEL_PACK_BUFFER, 0 ); slot->busy = 0;
+
+        if( data==nullptr ){ throw except_t( "gpu readback failed" ); } return out;
+    }
+
+    matrix_t wait_readback( const ptr_t<PBO>& slot ) const {
+        auto gl = RL::GL::Load(); while( slot->fence!=nullptr ){
+             auto state = gl->ClientWaitSync( slot->fence, RL::GL::SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL );
+             if  ( state == RL::GL::TIMEOUT_EXPIRED ){ continue; }
+             if  ( state == RL::GL::WAIT_FAILED ){ slot->busy = 0; throw except_t( "gpu readback failed" ); }
+        break; } return finish_readback( slot );
+    }
 
     /*─······································································─*/
 
-    string_t get_kernel_variables() const noexcept {
-    string_t out; for( auto x: obj->vars.data() ){ switch( x.second.type ){
+    bool is_tiled() const noexcept {
+        if( obj->texture.null() ){ return false; }
+        if( obj->width  > (uint) obj->texture->texture.width  ){ return true; }
+        if( obj->height > (uint) obj->texture->texture.height ){ return true; }
+        for( auto x: obj->vars.data() ){ if( x.second.type!=0x50 ){ continue; }
+             auto mat = x.second.value.as<ptr_t<matrix_t>>();
+             if( mat->width()>get_tile_size() || mat->height()>get_tile_size() ){ return true; }
+        }    return false;
+    }
+
+    /* input slices span the tile plus the halo on both sides, so the
+       tile shrinks until those still fit; 0 when the halo alone does not */
+    uint get_tile_size() const noexcept {
+        uint max = get_max_texture_size(), pad = 2*obj->halo;
+        max = pad<max ? max-pad : 0;
+        return obj->tile==0 || obj->tile>max ? max : obj->tile;
+    }
+
+    /* dispatches every tile of the output; each tile is read back one
+       step behind the next dispatch so transfers overlap with compute */
+    void run_tiles( function_t<void,matrix_t,uint,uint> cb ) {
+        uint tw = obj->texture->texture.width, th = obj->texture->texture.height;
+        uint gw = obj->width, gh = obj->height, hl = obj->halo;
+        map_t<string_t,DONE> backup; string_t lib; array_t<CALL> calls;
+
+        for( auto x: obj->vars.data() ){ if( x.second.type!=0x50 ){ continue; }
+             auto mat = x.second.value.as<ptr_t<matrix_t>>();
+             if( mat->width()<=get_tile_size() && mat->height()<=get_tile_size() ){ continue; }
+             if( mat->width()!=gw || mat->height()!=gh )
+               { throw except_t( "tiled inputs must match the output size" ); }
+             backup[ x.first ] = x.second; lib += regex::format( _tile_, x.first ) + "\n";
+             calls.push( CALL({ "texture", x.first, "gpu_tile_texture_" + x.first }) );
+        }
+
+        // the tile redirects and uniforms only live for this run, so later
+        // untiled runs neither compile nor bind them
+        auto prelude = obj->prelude; auto restore = [&](){
+             for( auto z: backup.data() ){ obj->vars[ z.first ] = z.second; obj->vars.erase( z.first+"_tile" ); }
+             obj->vars.erase( "gpu_tile" ); obj->wrappers = string_t(); obj->calls = array_t<CALL>();
+             obj->prelude = prelude; obj->shader = ptr_t<RL::Shader>();
+        };
+
+        obj->wrappers = lib; obj->calls = calls; obj->prelude = "uv += gpu_tile;";
+        obj->shader   = ptr_t<RL::Shader>();
+
+        struct ITEM { ptr_t<PBO> slot; uint x, y, w, h; }; ITEM prev; bool pending=0;
+
+        auto flush = [&](){ if( !pending ){ return; } pending=0;
+             cb( wait_readback( prev.slot ).slice( 0, 0, prev.w, prev.h ), prev.x, prev.y );
+        };
+
+        try { for( uint y=0; y<gh; y+=th ){ for( uint x=0; x<gw; x+=tw ){
+            uint w = gw-x<tw ? gw-x : tw, h = gh-y<th ? gh-y : th;
+
+            for( auto z: backup.data() ){
+                 auto mat = z.second.value.as<ptr_t<matrix_t>>();
+                 uint sx = x>hl ? x-hl : 0, sw = ( x+w+hl<gw ? x+w+hl : gw ) - sx;
+                 uint sy = y>hl ? y-hl : 0, sh = ( y+h+hl<gh ? y+h+hl : gh ) - sy;
+                 set_input( mat->slice( sx, sy, sw, sh ), z.first );
+                 set_input( vec4_t({ (float) sx/gw, (float) sy/gh, (float) gw/sw, (float) gh/sh }), z.first+"_tile" );
+            }    set_input( vec2_t({ (float) x, (float) y }), "gpu_tile" );
+
+            if( is_stale() ){ compile(); }
+            draw( *obj->texture ); auto slot = issue_readback( *obj->texture );
+
+            flush(); prev.slot=slot; prev.x=x; prev.y=y; prev.w=w; prev.h=h; pending=1;
+
+        }} flush(); } catch( except_t err ) { restore(); throw err; } restore();
+    }
 
-        case 0x01: out += regex::format( "uniform bool      ${0};\n", x.first ); break;
-        case 0x02: out += regex::format( "uniform int       ${0};\n", x.first ); break;
-        case 0x03: out += regex::format( "uniform uint      ${0};\n", x.first ); break;
-        case 0x04: out += regex::format( "uniform float     ${0};\n", x.first ); break;
+    void free_readback_ring() const noexcept {
+        auto gl = RL::GL::Load(); for( auto x: obj->ring ){ clear_readback( *x );
+            if( x->id   !=0 /*-*/ ){ gl->DeleteBuffers( 1, &x->id ); x->id=0; }
+        x->size=0; } obj->ring.clear();
+    }
+
+    /*─······································································─*/
 
-        case 0x11: out += regex::format( "uniform bvec2     ${0};\n", x.first ); break;
-        case 0x12: out += regex::format( "uniform ivec2     ${0};\n", x.first ); break;
-        case 0x13: out += regex::format( "uniform uvec2     ${0};\n", x.first ); break;
-        case 0x14: out += regex::format( "uniform  vec2     ${0};\n", x.first ); break;
+    string_t get_kernel_constants() const noexcept {
+    string_t out; for( auto x: obj->constants.data() ){
+        out += regex::format( "#define ${0} ${1}\n", x.first, x.second );
+    }   return out; }
 
-        case 0x21: out += regex::format( "uniform bvec3     ${0};\n", x.first ); break;
-        case 0x22: out += regex::format( "uniform ivec3     ${0};\n", x.first ); break;
-        case 0x23: out += regex::format( "uniform uvec3     ${0};\n", x.first ); break;
-        case 0x24: out += regex::format( "uniform  vec3     ${0};\n", x.first ); break;
+    gpu_t& set_kernel_constant( string_t name, string_t value ) {
+        if( name.empty() || value.empty() )
+          { throw except_t("invalid constant name"); }
+        if( regex::test( name, "^[ 0-9]+", true ) || regex::test( name, "[^a-z0-9_]+", true ) )
+          { throw except_t("invalid constant name"); }
 
-        case 0x31: out += regex::format( "uniform bvec4     ${0};\n", x.first ); break;
-        case 0x32: out += regex::format( "uniform ivec4     ${0};\n", x.first ); break;
-        case 0x33: out += regex::format( "uniform uvec4     ${0};\n", x.first ); break;
-        case 0x34: out += regex::format( "uniform  vec4     ${0};\n", x.first ); break;
+        if( obj->constants.has( name ) && obj->constants[ name ]==value ){ return *this; }
+        obj->constants[ name ] = value; obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    string_t get_kernel_outputs() const noexcept {
+        if( obj->outputs.empty() ){ return "gl_FragColor = init();"; }
+        string_t out = "gl_FragData[0] = init();"; ulong n = 1;
+        for( auto& x: obj->outputs ){
+             out += regex::format( " gl_FragData[${0}] = ${1};", string::to_string( n++ ), x.name );
+        }    return out;
+    }
 
-        case 0x50: out += regex::format( "uniform sampler2D ${0};\n", x.first ); break;
+    void set_output_textures() const {
+        if( obj->texture.null() ){ return; } auto& tex = obj->texture->texture;
+        for( auto& x: obj->outputs ){
+             if( x.texture.id!=0 && x.texture.width==tex.width && x.texture.height==tex.height ){ continue; }
+             if( x.texture.id!=0 ){ pool::put_texture( x.texture ); }
+             x.texture = pool::get_texture( tex.width, tex.height, x.format );
+        }
+    }
 
-    }} return out; }
+    string_t get_kernel_variables() const noexcept {
+    string_t out; for( auto x: obj->vars.data() ){
+         auto type = get_uniform_type( x.second.type ); if( type==nullptr ){ continue; }
+         out += regex::format( "uniform ${0} ${1};\n", type, x.first );
+    }    for( auto& x: obj->outputs ){ out += regex::format( "vec4 ${0};\n", x.name ); }
+    return out; }
 
 public: 
 
@@ -454,17 +1415,96 @@ public:
     /*─······································································─*/
 
     gpu_t& remove_input( string_t name ) /*const noexcept*/ { 
-        obj->vars.erase(name); return *this; 
+        if( !obj->vars.has( name ) ){ return *this; }
+        obj->vars.erase(name); obj->shader = ptr_t<RL::Shader>(); return *this; 
+    }
+
+    /* baked into the source as a #define: every distinct set of constants
+       is its own program variant in the cache, picked again on change */
+    gpu_t& set_constant( string_t name, string_t value ){ return set_kernel_constant( name, value ); }
+    gpu_t& set_constant( string_t name, const char* value ){ return set_kernel_constant( name, value ); }
+    gpu_t& set_constant( string_t name, bool  value ){ return set_kernel_constant( name, value ? "true" : "false" ); }
+    gpu_t& set_constant( string_t name, int   value ){ return set_kernel_constant( name, string::to_string( value ) ); }
+    gpu_t& set_constant( string_t name, uint  value ){ return set_kernel_constant( name, string::to_string( value ) + "u" ); }
+
+    gpu_t& set_constant( string_t name, double value ){
+        char buff[32]; snprintf( buff, 32, "%.9g", value ); string_t out = buff;
+        if( !regex::test( out, "[.en]" ) ){ out += ".0"; } /*------------------*/
+        return set_kernel_constant( name, out );
+    }
+
+    gpu_t& remove_constant( string_t name ) {
+        if( !obj->constants.has( name ) ){ return *this; }
+        obj->constants.erase( name ); obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    /* registers this kernel's counters under `name` in gpu::stats::to_json() */
+    gpu_t& set_name( string_t name ) {
+        if( name.empty() ){ throw except_t("invalid kernel name"); }
+        stats::_registry_[ name ] = obj->stats; return *this;
+    }
+
+    stats_t get_stats() const noexcept { poll_query(); return *obj->stats; }
+
+    /* runs instead of the shader while no GL context exists, see gpu/cpu.h */
+    gpu_t& set_fallback( function_t<matrix_t,gpu_t&> cb ) noexcept {
+        obj->fallback = type::bind( cb ); return *this;
+    }
+
+    bool has_fallback() const noexcept { return !obj->fallback.null(); }
+
+    gpu_t& set_library( string_t source ) /*const noexcept*/ {
+        if( obj->library==source ){ return *this; }
+        obj->library = source; obj->shader = ptr_t<RL::Shader>(); return *this;
     }
 
     /*─······································································─*/
 
-    gpu_t& set_output( uint width, uint height, uint format=OUT_DOUBLE4 ) noexcept {
+    gpu_t& set_output( uint width, uint height, uint format=OUT_DOUBLE4 ) {
     if( !is_closed() ){
-        if( !obj->texture.null() ) { RL::UnloadRenderTexture( *obj->texture ); }
-        /**/ obj->texture =type::bind( RL::LoadRenderTexture( width, height, format ) );
+        obj->width = width; obj->height = height; obj->format = format;
+        if( !_gpu_ ){ return *this; } // no context: only the CPU fallback can run
+        uint max   = get_tile_size(); /*-----------------------------*/
+        if( max==0 ){ throw except_t("tiling halo exceeds the max texture size"); }
+        if( !obj->texture.null() ) { pool::put_target( *obj->texture ); }
+        /**/ obj->texture =type::bind( pool::get_target(
+             width<max ? width : max, height<max ? height : max, format
+        ));  set_output_textures();
     } return *this; }
 
+    /* declares an extra `vec4 name` the kernel writes next to its return
+       value; every output is filled by the same pass through MRT */
+    gpu_t& add_output( string_t name, uint format=OUT_DOUBLE4 ) {
+        if( name.empty() || name=="output" )
+          { throw except_t("invalid output name"); }
+        if( regex::test( name, "^[ 0-9]+", true ) || regex::test( name, "[^a-z0-9_]+", true ) )
+          { throw except_t("invalid output name"); }
+        if( get_channels( format )==0 )
+          { throw except_t("invalid output format"); }
+        if( obj->outputs.size()>=7 )
+          { throw except_t("too many gpu outputs"); }
+
+        for( auto& x: obj->outputs ){ if( x.name==name ){ throw except_t("output already exists"); } }
+
+        OUTPUT item; item.name = name; item.format = format; item.texture = RL::Texture2D({ 0 });
+        obj->outputs.push( item ); obj->shader = ptr_t<RL::Shader>();
+        set_output_textures(); return *this;
+    }
+
+    gpu_t& set_tiling( uint tile, uint halo=0 ) {
+        if( _gpu_ && 2*halo>=get_max_texture_size() )
+          { throw except_t("tiling halo exceeds the max texture size"); }
+        obj->tile = tile; obj->halo = halo;
+        if( obj->width>0 ){ set_output( obj->width, obj->height, obj->format ); }
+        return *this;
+    }
+
+    /* streams every output tile as (tile, x, y) instead of stitching */
+    gpu_t& tiles( function_t<void,matrix_t,uint,uint> cb ) { if( !is_closed() ){
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        run_tiles( cb ); return *this;
+    } throw except_t( "gpu kernel closed" ); }
+
     template< class T >
     gpu_t& set_input( const T& value, string_t name ) /*const noexcept*/ {
 
@@ -478,79 +1518,261 @@ public:
         if( regex::test( name, "[^a-z0-9_]+", true ) )
           { throw except_t("invalid variable name"); }
         
-        DONE item; item.type = gpu_type_id<T>::value;
-        /*------*/ item.value= type::bind( value );
-        obj->vars  [ name ]  = item;
+        DONE item; item.type   = gpu_type_id<T>::value;
+        /*------*/ item.value  = type::bind( value );
+        /*------*/ item.version= ++obj->version;
+
+        if( obj->vars.has( name ) && obj->vars[ name ].type==item.type )
+             { item.slot = obj->vars[ name ].slot; }
+        else { item.slot = ptr_t<SLOT>( new SLOT() ); obj->shader = ptr_t<RL::Shader>(); }
+
+        obj->vars[ name ] = item;
     
     return *this; }
 
     gpu_t& compile() /*const noexcept*/ {
         if( obj->kernel.empty() ){ throw except_t("no kernel found"); }
-        if(!obj->shader.null () ){ RL::UnloadShader( *obj->shader ); }
-
-        obj->shader = type::bind( RL::LoadShaderFromMemory( 0,
-            regex::format( _kernel_, GLSL_VERSION, 
-                get_kernel_variables(), /*------*/
-                get_kernel_soruce() /*----------*/
-            ).get()
-        ));
-        
-        if( !RL::IsShaderValid( *obj->shader ) )
-          { throw except_t("Invalid Shader"); }
+        pool::check_owner(); /*------------------------------*/
+
+        stats::scope_t scope( &obj->stats ); auto time = stats::now();
+
+        set_program( cache::get( get_program() ) );
+        for( auto x: obj->vars.data() ){ get_location( x.first, x.second ); }
+        stats::add_compile( stats::now() - time );
 
     return *this; }
 
     /*─······································································─*/
 
     void free() const noexcept { if( !is_closed() ){
-        if( !obj->texture.null() ){ RL::UnloadRenderTexture( *obj->texture ); }
-        if( !obj->shader .null() ){ RL::UnloadShader( *obj->shader ); }
+        if( !obj->texture.null() ){ pool::put_target( *obj->texture ); }
+        if( !obj->ring   .empty()){ free_readback_ring(); /*------*/ }
+        for( auto& x: obj->outputs ){ pool::put_texture( x.texture ); }
+        if( obj->query!=0 && _gpu_ ){ RL::GL::Load()->DeleteQueries( 1, &obj->query ); }
         /**/ obj->state = 0; /*------------------------------------*/
     }}
 
     /*─······································································─*/
 
+    RL::Texture2D get() const {
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        /**/ return obj->texture->texture; /*------------------------*/
+    }
+
+    RL::Texture2D get( string_t name ) const {
+        if( name=="output" ){ return get(); } for( auto& x: obj->outputs ){
+        if( x.name==name && x.texture.id!=0 ){ return x.texture; }
+        }   throw except_t("invalid output name");
+    }
+
+    RL::Texture2D render() /**/ { if( !is_closed() ){
+        if( !_gpu_ ) /*------*/ { throw except_t("gpu machine not started"); }
+        pool::check_owner(); /*-------------------------------------*/
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
+        draw( *obj->texture ); return obj->texture->texture;
+    } throw except_t( "gpu kernel closed" ); }
+
+    RL::Texture2D render( const RL::RenderTexture2D& target ) { if( !is_closed() ){
+        if( !_gpu_ ) /*------*/ { throw except_t("gpu machine not started"); }
+        pool::check_owner(); /*-------------------------------------*/
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
+        draw( target ); return target.texture;
+    } throw except_t( "gpu kernel closed" ); }
+
+    /*─······································································─*/
+
     matrix_t operator()()/**/{ if( !is_closed() ){
+        if( !_gpu_ ) /*------*/ { return run_fallback(); }
         if( obj->texture.null() ){ throw except_t("invalid texture"); }
-        if( obj->shader .null() ){ compile(); /*-------------------*/ }
+        pool::check_owner(); stats::scope_t scope( &obj->stats ); /*--*/
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
 
-        int w = obj->texture->texture.width ;
-        int h = obj->texture->texture.height;
+        if( is_tiled() ){ matrix_t out( obj->width, obj->height, obj->format );
+            run_tiles([&]( matrix_t tile, uint x, uint y ){
+                out.paste( tile, x, y, tile.width(), tile.height() );
+            }); return out;
+        }
 
-        RL::BeginTextureMode( *obj->texture ); RL::ClearBackground( RL::BLACK );
-        RL::BeginShaderMode ( *obj->shader  ); set_kernel_variables(); /*-----*/
-        RL::DrawRectangle( 0,0, w, h, RL::WHITE );
-        RL::EndShaderMode(); RL::EndTextureMode();
+        draw( *obj->texture ); return matrix_t( obj->texture->texture );
+
+    } throw except_t( "gpu kernel closed" ); }
+
+    /* one pass, every output read back: the primary one under "output" */
+    map_t<string_t,matrix_t> outputs() { if( !is_closed() ){
+        if( !_gpu_ && obj->outputs.empty() ){
+            map_t<string_t,matrix_t> out; out[ "output" ] = run_fallback(); return out;
+        }
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        pool::check_owner(); /*-------------------------------------*/
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
+        if( is_tiled() ){ throw except_t("tiled kernels support a single output"); }
+        stats::scope_t scope( &obj->stats ); /*----------------------*/
 
-        return matrix_t( obj->texture->texture );
+        map_t<string_t,matrix_t> out; draw( *obj->texture );
+        out[ "output" ] = matrix_t( obj->texture->texture );
+        for( auto& x: obj->outputs ){ out[ x.name ] = matrix_t( x.texture ); }
+        return out;
 
     } throw except_t( "gpu kernel closed" ); }
 
+    /*─······································································─*/
+
+    promise_t<matrix_t,except_t> run_async() /**/ { if( !is_closed() ){
+        if( !_gpu_ ){ gpu_t self = *this;
+            return promise_t<matrix_t,except_t>([=](
+                function_t<void,matrix_t> res, function_t<void,except_t> rej
+            ){ process::add([=](){
+                try { gpu_t kernel = self; res( kernel.run_fallback() ); }
+                catch( except_t err ){ rej( err ); } return -1;
+            }); });
+        }
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        pool::check_owner(); /*-------------------------------------*/
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
+
+        if( is_tiled() ){ throw except_t("run_async does not support tiled kernels"); }
+
+        auto gl   = RL::GL::Load(); draw( *obj->texture );
+        auto slot = issue_readback( *obj->texture );
+        gpu_t self= *this; // keeps the kernel alive until the readback lands
+
+    return promise_t<matrix_t,except_t>([=]( 
+        function_t<void,matrix_t> res, function_t<void,except_t> rej 
+    ){ process::add([=](){
+
+        if( self.is_closed() ){ rej( except_t( "gpu kernel closed" ) ); return -1; }
+
+        if( slot->fence!=nullptr ){ // null once the pixels were read synchronously
+            auto state = gl->ClientWaitSync( slot->fence, 0, 0 );
+            if ( state == RL::GL::TIMEOUT_EXPIRED ){ return 1; }
+
+            if ( state == RL::GL::WAIT_FAILED ){ clear_readback( *slot );
+                 rej( except_t( "gpu readback failed" ) ); return -1;
+            }
+        }
+
+        try { res( self.finish_readback( slot ) ); }
+        catch( except_t err ){ rej( err ); } return -1;
+
+    }); }); } throw except_t( "gpu kernel closed" ); }
+
 };}}
 
 /*────────────────────────────────────────────────────────────────────────────*/
 
-namespace nodepp { namespace gpu { bool _gpu_ = false;
+#ifdef GPU_HEADLESS
+namespace nodepp { namespace gpu { namespace egl {
+
+    enum {
+        EXTENSIONS      = 0x3055, NONE          = 0x3038, OPENGL_API  = 0x30A2,
+        SURFACE_TYPE    = 0x3033, PBUFFER_BIT   = 0x0001, WIDTH       = 0x3057,
+        RENDERABLE_TYPE = 0x3040, OPENGL_BIT    = 0x0008, HEIGHT      = 0x3056,
+        RED_SIZE        = 0x3024, GREEN_SIZE    = 0x3023, BLUE_SIZE   = 0x3022,
+        ALPHA_SIZE      = 0x3021, CONTEXT_MAJOR = 0x3098, CONTEXT_MINOR = 0x30FB,
+        CONTEXT_PROFILE = 0x30FD, CORE_PROFILE  = 0x0001,
+        PLATFORM_SURFACELESS = 0x31DD
+    };
+
+    struct NODE { void* display=nullptr; void* context=nullptr; void* surface=nullptr; };
+    NODE _egl_;
+
+    bool has_extension( void* dpy, const char* name ) {
+        const char* list = eglQueryString( dpy, EXTENSIONS );
+        return list!=nullptr && strstr( list, name )!=nullptr;
+    }
+
+    /* surfaceless Mesa platform first (llvmpipe on display-less hosts),
+       then whatever the default display resolves to */
+    void* get_display() {
+        typedef void* (*FN)( unsigned int, void*, const int* );
+        if( has_extension( nullptr, "EGL_MESA_platform_surfaceless" ) ){
+            auto fn = (FN) eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+            if( fn!=nullptr ){ auto dpy = fn( PLATFORM_SURFACELESS, nullptr, nullptr );
+            if( dpy!=nullptr && eglInitialize( dpy, nullptr, nullptr ) ){ return dpy; } }
+        }
+        auto dpy = eglGetDisplay( nullptr );
+        if( dpy!=nullptr && eglInitialize( dpy, nullptr, nullptr ) ){ return dpy; }
+        throw except_t( "EGL display not found" );
+    }
+
+    void close() {
+        if( _egl_.display==nullptr ){ return; }
+        eglMakeCurrent( _egl_.display, nullptr, nullptr, nullptr );
+        if( _egl_.surface!=nullptr ){ eglDestroySurface( _egl_.display, _egl_.surface ); }
+        if( _egl_.context!=nullptr ){ eglDestroyContext( _egl_.display, _egl_.context ); }
+        eglTerminate( _egl_.display ); _egl_ = NODE();
+    }
+
+    void open() {
+        const int cfg_attr[] = {
+            SURFACE_TYPE, PBUFFER_BIT, RENDERABLE_TYPE, OPENGL_BIT,
+            RED_SIZE, 8, GREEN_SIZE, 8, BLUE_SIZE, 8, ALPHA_SIZE, 8, NONE
+        };
+        const int ctx_attr[] = {
+            CONTEXT_MAJOR, 3, CONTEXT_MINOR, 3,
+            CONTEXT_PROFILE, CORE_PROFILE, NONE
+        };
+        const int buf_attr[] = { WIDTH, 1, HEIGHT, 1, NONE };
+
+        _egl_.display = get_display(); void* cfg = nullptr; int count = 0;
+
+        if( !eglBindAPI( OPENGL_API ) )
+          { close(); throw except_t( "EGL desktop OpenGL not supported" ); }
+        if( !eglChooseConfig( _egl_.display, cfg_attr, &cfg, 1, &count ) || count==0 )
+          { close(); throw except_t( "EGL config not found" ); }
+
+        _egl_.context = eglCreateContext( _egl_.display, cfg, nullptr, ctx_attr );
+        if( _egl_.context==nullptr ){ close(); throw except_t( "EGL context failed" ); }
+
+        if( !has_extension( _egl_.display, "EGL_KHR_surfaceless_context" ) ){
+            _egl_.surface = eglCreatePbufferSurface( _egl_.display, cfg, buf_attr );
+            if( _egl_.surface==nullptr ){ close(); throw except_t( "EGL pbuffer failed" ); }
+        }
+
+        if( !eglMakeCurrent( _egl_.display, _egl_.surface, _egl_.surface, _egl_.context ) )
+          { close(); throw except_t( "EGL make current failed" ); }
+
+        RL::rlLoadExtensions( (void*) eglGetProcAddress ); RL::rlglInit( 1, 1 );
+    }
+
+}}}
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu {
+
+#ifdef GPU_HEADLESS
+
+    void stop_machine () { if( _gpu_ ){ cache::clear(); pool::clear(); _gpu_=false; RL::rlglClose(); egl::close(); }}
+
+    bool start_machine() { if(!_gpu_ ){ try {
+         egl::open(); _gpu_=true; /*---------------------*/
+         process::onSIGEXIT([=](){ stop_machine(); });
+    } catch(...) { return false; }} return true; }
+
+#else
 
-    void stop_machine () { if( _gpu_ ){ RL::CloseWindow(); }}
+    void stop_machine () { if( _gpu_ ){ cache::clear(); pool::clear(); _gpu_=false; RL::CloseWindow(); }}
 
     bool start_machine() { if(!_gpu_ ){ try {
          RL::SetConfigFlags( RL::FLAG_WINDOW_HIDDEN );
          RL::InitWindow( 100, 100, "gpupp" );
-         RL::SetTargetFPS( 120 ); /*-------*/
+         RL::SetTargetFPS( 120 ); _gpu_=true;
          process::onSIGEXIT([=](){ stop_machine(); });
     } catch(...) { return false; }} return true; }
 
+#endif
+
     void save_canvas( matrix_t input, string_t path ) {
-        auto image = RL::LoadImageFromTexture(input.get());
-        RL::ExportImage( image, path.get() ); RL::UnloadImage( image );
+        RL::ExportImage( input.get_image(), path.get() );
     }
 
     ptr_t<uchar> get_canvas( matrix_t input ) {
-        auto image = RL::LoadImageFromTexture( input.get() );
         int  size  = 0; /*---------------------------------*/
-        auto data  = RL::ExportImageToMemory( image, ".png", &size );
-        RL::UnloadImage( image ); return ptr_t<uchar>( data, (ulong) size );
+        auto data  = RL::ExportImageToMemory( input.get_image(), ".png", &size );
+        return ptr_t<uchar>( data, (ulong) size );
     }
 
 }}
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_LINALG
+#define NODEPP_GPU_LINALG
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "cpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class dense_t {
+protected:
+
+    struct NODE {
+        uint rows=0, cols=0;
+        matrix_t matrix;
+    };  ptr_t<NODE> obj;
+
+public:
+
+    /* row-packed: texel (j,i) holds elements [i][4j..4j+3], the padding
+       lanes of the last column block are always zero */
+    static uint get_blocks( uint cols ) noexcept { return ( cols + 3 ) / 4; }
+
+    /*─······································································─*/
+
+    dense_t( uint rows, uint cols, ptr_t<float> data ) : obj( new NODE() ) {
+        if( rows * cols == 0 || (ulong) rows * cols != data.size() )
+          { throw except_t( "dense ptr size must be", rows * cols ); }
+
+        uint blocks = get_blocks( cols ); obj->rows = rows; obj->cols = cols;
+        ptr_t<uchar> raw( (ulong) blocks * rows * 4 * sizeof(float), 0x00 );
+
+        for( ulong y=0; y<rows; ++y ){
+             memcpy( &raw + y * blocks * 4 * sizeof(float), &data + y * cols, cols * sizeof(float) );
+        }    obj->matrix = matrix_t( blocks, rows, raw, OUT_DOUBLE4 );
+    }
+
+    dense_t( matrix_t packed, uint rows, uint cols ) : obj( new NODE() ) {
+        if( packed.format()!=OUT_DOUBLE4 || packed.width()!=get_blocks( cols ) || packed.height()!=rows )
+          { throw except_t( "invalid packed dense matrix" ); }
+        obj->rows = rows; obj->cols = cols; obj->matrix = packed;
+    }
+
+    dense_t() noexcept : obj( new NODE() ){}
+
+    /*─······································································─*/
+
+    uint rows() const noexcept { return obj->rows; }
+    uint cols() const noexcept { return obj->cols; }
+
+    matrix_t get() const noexcept { return obj->matrix; }
+
+    ptr_t<float> data() const noexcept {
+        ulong size = (ulong) obj->rows * obj->cols, stride = get_blocks( obj->cols ) * 4;
+        ptr_t<float> out( size, 0x00 ); if( size==0 ){ return out; }
+        auto src = (float*) obj->matrix.get_image().data;
+
+        for( ulong y=0; y<obj->rows; ++y ){
+             memcpy( &out + y * obj->cols, src + y * stride, obj->cols * sizeof(float) );
+        }    return out;
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* register-blocked GEMM: every fragment owns ROWS output texels, four
+   columns of ROWS consecutive rows, so each B texel fetched per K step
+   feeds ROWS accumulators. Rows past the first leave through the MRT
+   outputs named in ${0}; there is no shared-memory tile */
+namespace nodepp { namespace gpu { string_t _matmul_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); int y = p.y * ROWS; int b = y / M_ROWS;
+    int base = B_BATCHED ? b * K_SIZE : 0; vec4 acc[ROWS];
+    for( int i=0; i<ROWS; i++ ){ acc[i] = vec4( 0.0 ); }
+
+    for( int k=0; k<K_BLOCKS; k+=UNROLL ){ for( int u=0; u<UNROLL; u++ ){
+         int kb = k + u; if( kb>=K_BLOCKS ){ break; } int r = kb * 4;
+         vec4 b0 = /*---*/ texelFetch( B, ivec2( p.x, base + r     ), 0 );
+         vec4 b1 = r+1<K_SIZE ? texelFetch( B, ivec2( p.x, base + r + 1 ), 0 ) : vec4( 0.0 );
+         vec4 b2 = r+2<K_SIZE ? texelFetch( B, ivec2( p.x, base + r + 2 ), 0 ) : vec4( 0.0 );
+         vec4 b3 = r+3<K_SIZE ? texelFetch( B, ivec2( p.x, base + r + 3 ), 0 ) : vec4( 0.0 );
+    for( int i=0; i<ROWS; i++ ){ vec4 a = texelFetch( A, ivec2( kb, y + i ), 0 );
+         acc[i] += a.x * b0 + a.y * b1 + a.z * b2 + a.w * b3;
+    }}}  ${0} return acc[0];
+);}}
+
+namespace nodepp { namespace gpu { string_t _transpose_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); int r = p.x * 4; int t = p.y / 4; int s = p.y - t * 4;
+    vec4 out = vec4( 0.0 ); for( int u=0; u<4; u++ ){
+         if( r+u>=A_ROWS ){ break; } out[u] = texelFetch( A, ivec2( t, r + u ), 0 )[s];
+    }    return out;
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace cpu {
+
+    /* the _matmul_ loop on the row-packed texels: one output texel is four
+       columns, so every step is a broadcast multiply-add over a texel_t */
+    matrix_t matmul( const matrix_t& a, const matrix_t& b, uint m, uint k, bool batched ) {
+        uint ka = a.width(), nb = b.width(), rows = a.height();
+        const float* pa = (const float*) &a.raw(); const float* pb = (const float*) &b.raw();
+        matrix_t out( nb, rows, OUT_DOUBLE4 ); float* dst = (float*) &out.raw();
+
+        parallel_for( rows, [&]( ulong begin, ulong end ){ for( ulong y=begin; y<end; ++y ){
+            ulong base = batched ? ( y / m ) * k : 0; const float* row = pa + y * ka * 4;
+            for( ulong x=0; x<nb; ++x ){ texel_t acc;
+            for( ulong r=0; r<k; ++r ){ acc += row[r] * texel_t::load( pb + ( ( base + r ) * nb + x ) * 4 ); }
+                 acc.store( dst + ( y * nb + x ) * 4 );
+            }
+        }}, 1 + GPU_CPU_GRAIN / ( (ulong) nb * k + 1 ) );
+
+        return out;
+    }
+
+    matrix_t transpose( const matrix_t& a, uint rows, uint cols ) {
+        uint ka = a.width(), blocks = ( rows + 3 ) / 4; const float* pa = (const float*) &a.raw();
+        matrix_t out( blocks, cols, OUT_DOUBLE4 ); float* dst = (float*) &out.raw();
+
+        parallel_for( cols, [&]( ulong begin, ulong end ){ for( ulong y=begin; y<end; ++y ){
+        for( ulong r=0; r<rows; ++r ){ dst[ y * blocks * 4 + r ] = pa[ r * ka * 4 + y ]; }
+        }}, 1 + GPU_CPU_GRAIN / ( rows + 1 ) );
+
+        return out;
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace linalg {
+
+    /* K/4 blocks walked per loop step: short reductions unroll completely,
+       long ones keep the body small enough to stay in the shader cache.
+       Every blocked row adds an accumulator, so deep blocks unroll less */
+    uint get_unroll( uint blocks, uint rows=1 ) noexcept {
+        uint out = blocks<=16 ? blocks : blocks<=256 ? 8 : 4;
+        if( rows>=4 && out>4 ){ out /= 2; } return out>0 ? out : 1;
+    }
+
+    /* rows per fragment: a block never straddles two batches, and the
+       blocked target has to fit without tiling since outputs() can't tile */
+    uint get_rows( uint m, uint rows, uint cols ) noexcept {
+        uint max = get_max_texture_size(); if( cols>max ){ return 1; }
+        for( uint x: { 4u, 2u } ){ if( m%x==0 && rows/x<=max ){ return x; }}
+        return 1;
+    }
+
+    /*─······································································─*/
+
+    /* C[b] = A[b] * B[b] for `batch` matrices stacked vertically; B is
+       shared by every batch when it only holds a single K x N matrix */
+    dense_t matmul( const dense_t& a, const dense_t& b, uint batch=1 ) {
+        if( batch==0 || a.rows() % batch!=0 ){ throw except_t( "invalid gemm batch" ); }
+
+        uint m = a.rows() / batch, k = a.cols(), n = b.cols();
+        bool batched = b.rows() == k * batch && batch>1;
+        if( !batched && b.rows()!=k ){ throw except_t( "invalid gemm shape" ); }
+
+        if( !_gpu_ ){ return dense_t( cpu::matmul( a.get(), b.get(), m, k, batched ), a.rows(), n ); }
+
+        uint blocks = dense_t::get_blocks( k ), nb = dense_t::get_blocks( n );
+        uint rows   = get_rows( m, a.rows(), nb ); string_t store;
+        for( uint x=1; x<rows; ++x ){
+             store += regex::format( "gpu_row${0} = acc[${0}]; ", string::to_string( x ) );
+        }
+
+        gpu_t kernel( regex::format( _matmul_, store ) ); kernel
+            .set_constant( "M_ROWS"   , (int) m      )
+            .set_constant( "K_SIZE"   , (int) k      )
+            .set_constant( "K_BLOCKS" , (int) blocks )
+            .set_constant( "ROWS"     , (int) rows   )
+            .set_constant( "UNROLL"   , (int) get_unroll( blocks, rows ) )
+            .set_constant( "B_BATCHED", batched      )
+            .set_output  ( nb, a.rows() / rows, OUT_DOUBLE4 )
+            .set_input   ( a.get(), "A" )
+            .set_input   ( b.get(), "B" );
+
+        if( rows==1 ){ return dense_t( kernel(), a.rows(), n ); }
+
+        // the blocked rows come back as separate targets: interleave them
+        for( uint x=1; x<rows; ++x ){ kernel.add_output( "gpu_row" + string::to_string( x ), OUT_DOUBLE4 ); }
+        auto list = kernel.outputs(); matrix_t out( nb, a.rows(), OUT_DOUBLE4 );
+        float* dst = (float*) &out.raw(); ulong line = (ulong) nb * 4;
+
+        for( uint x=0; x<rows; ++x ){
+             auto src = (const float*) &list[ x==0 ? string_t( "output" ) : "gpu_row" + string::to_string( x ) ].raw();
+        for( ulong y=0; y<a.rows()/rows; ++y ){
+             memcpy( dst + ( y * rows + x ) * line, src + y * line, line * sizeof(float) );
+        }}
+
+        return dense_t( out, a.rows(), n );
+    }
+
+    dense_t transpose( const dense_t& a ) {
+        if( !_gpu_ ){ return dense_t( cpu::transpose( a.get(), a.rows(), a.cols() ), a.cols(), a.rows() ); }
+
+        gpu_t kernel( _transpose_ ); kernel
+            .set_constant( "A_ROWS", (int) a.rows() )
+            .set_output  ( dense_t::get_blocks( a.rows() ), a.cols(), OUT_DOUBLE4 )
+            .set_input   ( a.get(), "A" );
+
+        return dense_t( kernel(), a.cols(), a.rows() );
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_PIPELINE
+#define NODEPP_GPU_PIPELINE
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class stream_t; class pipeline_t {
+protected: friend class stream_t;
+
+    struct STAGE {
+        gpu_t    kernel; string_t input;
+        uint     iter  ; bool     tap  ;
+        matrix_t output; ptr_t<RL::RenderTexture2D> pong;
+    };
+
+    struct NODE {
+        array_t<STAGE> stages;
+        bool /*----*/ state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    RL::RenderTexture2D get_pong( STAGE& stage ) const {
+        auto tex = stage.kernel.get();
+
+        if( !stage.pong.null() ){
+        if(  stage.pong->texture.width ==tex.width  &&
+             stage.pong->texture.height==tex.height &&
+             stage.pong->texture.format==tex.format
+        ) {  return *stage.pong; } pool::put_target( *stage.pong ); }
+
+        stage.pong = type::bind( pool::get_target( tex.width, tex.height, tex.format ) );
+        return *stage.pong;
+    }
+
+    RL::Texture2D run_stage( STAGE& stage, RL::Texture2D input ) const {
+        RL::Texture2D out = input;
+
+        if( stage.input.empty() ){ return stage.kernel.render(); }
+
+        // a kernel fed its own target must not write it on the first pass
+        uint skew = input.id==stage.kernel.get().id ? 1 : 0;
+
+        for( uint x=0; x<stage.iter; ++x ){
+             stage.kernel.set_input( out, stage.input );
+             out = (x+skew)%2==0 ? stage.kernel.render()
+                                 : stage.kernel.render( get_pong( stage ) );
+        }
+
+        return out;
+    }
+
+    RL::Texture2D run_stages( RL::Texture2D input, ulong count ) const {
+        if( obj->stages.empty() ){ throw except_t("empty pipeline"); }
+        RL::Texture2D out = input;
+
+        for( ulong x=0; x<count; ++x ){ auto& stage = obj->stages[x];
+             out = run_stage( stage, out ); if( !stage.tap ){ continue; }
+             stage.output = matrix_t( out ); /*-----------------------*/
+        }
+
+        return out;
+    }
+
+public:
+
+    pipeline_t() noexcept : obj( new NODE() ){}
+    virtual ~pipeline_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    void free() const noexcept { if( !is_closed() ){
+        for( auto& x: obj->stages ){ if( x.pong.null() ){ continue; }
+             pool::put_target( *x.pong );
+        }    obj->stages.clear(); obj->state = 0;
+    }}
+
+    /*─······································································─*/
+
+    ulong size() const noexcept { return obj->stages.size(); }
+
+    pipeline_t& add( gpu_t kernel, string_t input="", uint iterations=1 ) {
+        if( is_closed() ){ throw except_t("pipeline closed"); }
+        if( iterations==0 ){ throw except_t("invalid iteration count"); }
+        if( obj->stages.empty() && input.empty() )
+          { throw except_t("first stage needs an input name"); }
+        if( !obj->stages.empty() && !input.empty() &&
+             &obj->stages[ obj->stages.size()-1 ].kernel.obj==&kernel.obj )
+          { throw except_t("stage would read its own target"); }
+
+        STAGE item; item.kernel = kernel; item.input= input;
+        /*-----*/ item.iter   = iterations; item.tap= false;
+        obj->stages.push( item ); return *this;
+    }
+
+    pipeline_t& tap( ulong stage ) {
+        if( stage>=obj->stages.size() ){ throw except_t("invalid pipeline stage"); }
+        obj->stages[stage].tap = true; return *this;
+    }
+
+    matrix_t get( ulong stage ) const {
+        if( stage>=obj->stages.size() ){ throw except_t("invalid pipeline stage"); }
+        return obj->stages[stage].output;
+    }
+
+    /*─······································································─*/
+
+    RL::Texture2D render( RL::Texture2D input ) const {
+        if( is_closed() ){ throw except_t("pipeline closed"); }
+        return run_stages( input, obj->stages.size() );
+    }
+
+    RL::Texture2D render( const matrix_t& input ) const { return render( input.get() ); }
+
+    matrix_t operator()( const matrix_t& input ) const {
+        return matrix_t( render( input ) );
+    }
+
+    /*─······································································─*/
+
+    promise_t<matrix_t,except_t> run_async( const matrix_t& input ) const {
+        if( is_closed() ){ throw except_t("pipeline closed"); }
+
+        ulong count= obj->stages.size(); if( count==0 ){ throw except_t("empty pipeline"); }
+        auto& last = obj->stages[ count-1 ];
+        auto  out  = run_stages( input.get(), count-1 );
+
+        // the final pass must land on the kernel's own target, so the
+        // intermediate passes alternate backwards from the pong buffer
+        if( !last.input.empty() && out.id==last.kernel.get().id && last.iter%2==1 )
+          { throw except_t("stage would read its own target"); }
+
+        if( !last.input.empty() ){ for( uint x=0; x+1<last.iter; ++x ){
+             last.kernel.set_input( out, last.input );
+             out = ( last.iter-2-x )%2==0 ? last.kernel.render( get_pong( last ) )
+                                          : last.kernel.render();
+        }    last.kernel.set_input( out, last.input ); }
+
+        return last.kernel.run_async();
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
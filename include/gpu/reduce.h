@@ -0,0 +1,199 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_REDUCE
+#define NODEPP_GPU_REDUCE
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "cpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_REDUCE_STEP
+#define GPU_REDUCE_STEP 4
+#endif
+
+namespace nodepp { namespace gpu { enum REDUCE_AXIS {
+    REDUCE_ALL = 0b00000011, // whole matrix -> 1x1
+    REDUCE_ROW = 0b00000001, // every row    -> 1xH
+    REDUCE_COL = 0b00000010  // every column -> Wx1
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { string_t _reduce_library_=GPU_KERNEL(
+    vec4 map    ( vec4 v, vec2 p ){ ${0} }
+    vec4 combine( vec4 a, vec4 b ){ ${1} }
+);}}
+
+namespace nodepp { namespace gpu { string_t _reduce_kernel_=GPU_KERNEL(
+    vec2 base = floor( uv ) * vec2( gpu_step ); vec4 acc = vec4( 0.0 ); bool has = false;
+    for( int y=0; y<gpu_step.y; y++ ){ for( int x=0; x<gpu_step.x; x++ ){
+         vec2 p = base + vec2( x, y ); if( p.x>=src_size.x || p.y>=src_size.y ){ continue; }
+         vec4 v = map( texture( src, ( p + 0.5 ) / src_size ), p );
+         acc = has ? combine( acc, v ) : v; has = true;
+    }}   return acc;
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class reduce_t {
+protected:
+
+    struct NODE {
+        array_t<gpu_t> passes;
+        string_t map, combine;
+        uint axis=REDUCE_ALL, width=0, height=0;
+        bool state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    /* one pass per log-step: each texel folds a GPU_REDUCE_STEP block of the
+       previous level, the first pass also applies map() to the source */
+    void set_passes( uint width, uint height ) {
+        if( obj->width==width && obj->height==height && !obj->passes.empty() ){ return; }
+        for( auto& x: obj->passes ){ x.free(); } obj->passes.clear();
+
+        uint w=width, h=height; bool first=true; do {
+            uint sx = obj->axis & REDUCE_ROW ? GPU_REDUCE_STEP : 1;
+            uint sy = obj->axis & REDUCE_COL ? GPU_REDUCE_STEP : 1;
+            uint nw = sx>1 ? ( w + sx - 1 ) / sx : w;
+            uint nh = sy>1 ? ( h + sy - 1 ) / sy : h;
+
+            gpu_t pass( _reduce_kernel_ ); pass
+                .set_library( regex::format( _reduce_library_,
+                    first ? obj->map : string_t( "return v;" ), obj->combine ))
+                .set_output ( nw, nh, OUT_DOUBLE4 )
+                .set_input  ( ivec2_t({ (int) sx, (int) sy }), "gpu_step" )
+                .set_input  (  vec2_t({ (float) w, (float) h }), "src_size" );
+
+            obj->passes.push( pass ); w=nw; h=nh; first=false;
+        } while( ( obj->axis & REDUCE_ROW && w>1 ) || ( obj->axis & REDUCE_COL && h>1 ) );
+
+        obj->width = width; obj->height = height;
+    }
+
+    gpu_t& run_passes( const matrix_t& input ) {
+        if( is_closed() ){ throw except_t("reduce closed"); }
+        set_passes( input.width(), input.height() );
+
+        obj->passes[0].set_input( input, "src" ); ulong last = obj->passes.size()-1;
+        for( ulong x=0; x<last; ++x ){
+             obj->passes[x+1].set_input( obj->passes[x].render(), "src" );
+        }    return obj->passes[last];
+    }
+
+public:
+
+    reduce_t( string_t combine, string_t map="return v;", uint axis=REDUCE_ALL ) : obj( new NODE() ) {
+        if( axis==0 || axis>REDUCE_ALL ){ throw except_t("invalid reduce axis"); }
+        obj->combine = combine; obj->map = map; obj->axis = axis;
+    }
+
+    reduce_t() noexcept : obj( new NODE() ){ obj->state = 0; }
+    virtual ~reduce_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    void free() const noexcept { if( !is_closed() ){
+        for( auto& x: obj->passes ){ x.free(); }
+        obj->passes.clear(); obj->state = 0;
+    }}
+
+    /*─······································································─*/
+
+    reduce_t& set_axis( uint axis ) {
+        if( axis==0 || axis>REDUCE_ALL ){ throw except_t("invalid reduce axis"); }
+        if( obj->axis==axis ){ return *this; }
+        for( auto& x: obj->passes ){ x.free(); } obj->passes.clear();
+        obj->axis = axis; return *this;
+    }
+
+    uint get_axis() const noexcept { return obj->axis; }
+
+    /*─······································································─*/
+
+    /* 1x1, 1xH or Wx1 RGBA32F result; only the final level is read back */
+    matrix_t operator()( const matrix_t& input ) { return run_passes( input )(); }
+
+    promise_t<matrix_t,except_t> run_async( const matrix_t& input ) {
+        return run_passes( input ).run_async();
+    }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace reduce {
+
+    string_t SUM    = "return a + b;";
+    string_t MIN    = "return min( a, b );";
+    string_t MAX    = "return max( a, b );";
+    string_t ARGMAX = "return b.x > a.x ? b : a;";
+
+    /*─······································································─*/
+
+    vec4_t get_value( const matrix_t& input, ulong index=0 ) {
+        auto data = input.to_float(); ulong x = index * 4;
+        if( data.size() < x+4 ){ throw except_t("invalid reduce result"); }
+        return vec4_t({ data[x], data[x+1], data[x+2], data[x+3] });
+    }
+
+    /*─······································································─*/
+
+    /* without a GL context the built-in reductions run on gpu::cpu */
+    texel_t get_texel( const texel_t& v, ulong, ulong ) noexcept { return v; }
+
+    matrix_t sum( const matrix_t& input, uint axis ){
+        if( !_gpu_ ){ return cpu::reduce( input, axis, get_texel, []( const texel_t& a, const texel_t& b ){ return a + b; } ); }
+        return reduce_t( SUM, "return v;", axis )( input );
+    }
+
+    matrix_t min( const matrix_t& input, uint axis ){
+        if( !_gpu_ ){ return cpu::reduce( input, axis, get_texel, []( const texel_t& a, const texel_t& b ){ return min( a, b ); } ); }
+        return reduce_t( MIN, "return v;", axis )( input );
+    }
+
+    matrix_t max( const matrix_t& input, uint axis ){
+        if( !_gpu_ ){ return cpu::reduce( input, axis, get_texel, []( const texel_t& a, const texel_t& b ){ return max( a, b ); } ); }
+        return reduce_t( MAX, "return v;", axis )( input );
+    }
+
+    vec4_t sum( const matrix_t& input ){ return get_value( sum( input, REDUCE_ALL ) ); }
+    vec4_t min( const matrix_t& input ){ return get_value( min( input, REDUCE_ALL ) ); }
+    vec4_t max( const matrix_t& input ){ return get_value( max( input, REDUCE_ALL ) ); }
+
+    vec4_t mean( const matrix_t& input ){
+        vec4_t out = sum( input ); float n = (float) input.width() * input.height();
+        if( n==0 ){ return out; } out.x /= n; out.y /= n; out.z /= n; out.w /= n;
+        return out;
+    }
+
+    /* position of the largest .x value */
+    uvec2_t argmax( const matrix_t& input ){
+        auto out = get_value( _gpu_ ? reduce_t( ARGMAX, "return vec4( v.x, p, 0.0 );" )( input ) : cpu::reduce( input, REDUCE_ALL,
+            []( const texel_t& v, ulong x, ulong y ){ return texel_t( v.x(), (float) x, (float) y, 0 ); },
+            []( const texel_t& a, const texel_t& b ){ return b.x() > a.x() ? b : a; }
+        ));
+        return uvec2_t({ (uint) out.y, (uint) out.z });
+    }
+
+}}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_SCAN
+#define NODEPP_GPU_SCAN
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* texels form one sequence in row-major order: i = y * width + x */
+namespace nodepp { namespace gpu { string_t _scan_library_=GPU_KERNEL(
+    vec4 combine( vec4 a, vec4 b ){ ${0} }
+    ivec2 gpu_at( int i, int w ){ return ivec2( i % w, i / w ); }
+);}}
+
+/* one Hillis-Steele step: every element folds the one gpu_offset behind it */
+namespace nodepp { namespace gpu { string_t _scan_step_=GPU_KERNEL(
+    ivec2 s = textureSize( src, 0 ); ivec2 p = ivec2( uv ); int i = p.y * s.x + p.x;
+    vec4  a = texelFetch( src, p, 0 ); if( i < gpu_offset ){ return a; }
+    return combine( texelFetch( src, gpu_at( i - gpu_offset, s.x ), 0 ), a );
+);}}
+
+namespace nodepp { namespace gpu { string_t _scan_shift_=GPU_KERNEL(
+    ivec2 s = textureSize( src, 0 ); ivec2 p = ivec2( uv ); int i = p.y * s.x + p.x;
+    if( i==0 ){ return IDENTITY; } return texelFetch( src, gpu_at( i - 1, s.x ), 0 );
+);}}
+
+/*─······································································─*/
+
+/* copies into a power-of-two sequence, everything from COUNT on is padding */
+namespace nodepp { namespace gpu { string_t _sort_pad_=GPU_KERNEL(
+    ivec2 s = textureSize( src, 0 ); ivec2 p = ivec2( uv ); int i = p.y * PW + p.x;
+    if( i >= COUNT ){ return vec4( 0.0 ); } return texelFetch( src, gpu_at( i, s.x ), 0 );
+);}}
+
+/* one compare-exchange step of the all-ascending bitonic network on
+   (is_pad, .x), payload in .yzw: the first step of every merge mirrors
+   the block, so the lower index always keeps the minimum. Padding is
+   the maximum and never moves, so its position alone marks it and no
+   key value, not even an infinite one, can sort behind it */
+namespace nodepp { namespace gpu { string_t _sort_step_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); int i = p.y * PW + p.x;
+    int   l = gpu_j * 2 == gpu_k ? i ^ ( gpu_k - 1 ) : i ^ gpu_j;
+    vec4  a = texelFetch( src, p, 0 ); vec4 b = texelFetch( src, gpu_at( l, PW ), 0 );
+    bool  pa = i >= COUNT, pb = l >= COUNT; float ka = SIGN * a.x, kb = SIGN * b.x;
+    bool  b_first = pa != pb ? pa : kb < ka;
+    bool  a_first = pa != pb ? pb : ka < kb;
+    return i < l ? ( b_first ? b : a ) : ( a_first ? b : a );
+);}}
+
+namespace nodepp { namespace gpu { string_t _sort_crop_=GPU_KERNEL(
+    ivec2 p = ivec2( uv ); int i = p.y * WIDTH + p.x;
+    return texelFetch( src, gpu_at( i, PW ), 0 );
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu {
+
+    /* per-channel inclusive or exclusive scan over the texel sequence,
+       log2(n) ping-pong passes that never leave the GPU */
+    matrix_t scan( const matrix_t& input, bool exclusive=false,
+                   string_t combine="return a + b;", string_t identity="vec4( 0.0 )" ) {
+        uint w = input.width(), h = input.height(); ulong n = (ulong) w * h;
+        RL::RenderTexture2D target[2] = { pool::get_target( w, h, OUT_DOUBLE4 ), pool::get_target( w, h, OUT_DOUBLE4 ) };
+        matrix_t out;
+
+        try {
+            gpu_t step( _scan_step_ ); step.set_library( regex::format( _scan_library_, combine ) );
+            RL::Texture2D tex = input.get(); uint flip = 0;
+
+            for( ulong offset=1; offset<n; offset<<=1 ){
+                 step.set_input( tex, "src" ).set_input( (int) offset, "gpu_offset" );
+                 tex = step.render( target[ flip ] ); flip ^= 1;
+            }
+
+            if( exclusive ){
+                gpu_t shift( _scan_shift_ ); shift
+                    .set_library ( regex::format( _scan_library_, combine ) )
+                    .set_constant( "IDENTITY", identity )
+                    .set_output  ( w, h, OUT_DOUBLE4 )
+                    .set_input   ( tex, "src" );
+                out = shift();
+            } else { out = matrix_t( tex ); }
+
+        } catch( except_t err ) {
+            for( auto& x: target ){ pool::put_target( x ); } throw err;
+        }   for( auto& x: target ){ pool::put_target( x ); }
+
+        return out;
+    }
+
+    /*─······································································─*/
+
+    /* bitonic sort of RGBA texels by .x, the other lanes travel with the key;
+       the sequence is padded to a power of two for the network */
+    matrix_t sort( const matrix_t& input, bool descending=false ) {
+        uint w = input.width(), h = input.height(), pw = 1, ph = 1;
+        while( pw < w ){ pw <<= 1; } while( ph < h ){ ph <<= 1; }
+        ulong n = (ulong) pw * ph;
+
+        RL::RenderTexture2D target[2] = { pool::get_target( pw, ph, OUT_DOUBLE4 ), pool::get_target( pw, ph, OUT_DOUBLE4 ) };
+        matrix_t out;
+
+        try {
+            string_t lib = regex::format( _scan_library_, "return a;" );
+            gpu_t pad( _sort_pad_ ), step( _sort_step_ ), crop( _sort_crop_ );
+
+            for( auto x: { &pad, &step, &crop } ){ x->set_library( lib )
+                 .set_constant( "PW"   , (int) pw )
+                 .set_constant( "COUNT", (int) w * h )
+                 .set_constant( "SIGN" , descending ? -1.0 : 1.0 );
+            }
+
+            pad.set_input( input, "src" ); RL::Texture2D tex = pad.render( target[0] ); uint flip = 1;
+
+            for( ulong k=2; k<=n; k<<=1 ){ for( ulong j=k/2; j>0; j>>=1 ){
+                 step.set_input( tex, "src" ).set_input( (int) k, "gpu_k" ).set_input( (int) j, "gpu_j" );
+                 tex = step.render( target[ flip ] ); flip ^= 1;
+            }}
+
+            crop.set_constant( "WIDTH", (int) w ).set_output( w, h, OUT_DOUBLE4 ).set_input( tex, "src" );
+            out = crop();
+
+        } catch( except_t err ) {
+            for( auto& x: target ){ pool::put_target( x ); } throw err;
+        }   for( auto& x: target ){ pool::put_target( x ); }
+
+        return out;
+    }
+
+}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
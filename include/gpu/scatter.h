@@ -0,0 +1,212 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_SCATTER
+#define NODEPP_GPU_SCATTER
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "cpu.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* every input texel emits `gpu_lanes` points; position() returns the output
+   texel a point lands on and value() what it adds there */
+namespace nodepp { namespace gpu { string_t _scatter_vertex_=GPU_KERNEL(
+    ${0} uniform sampler2D src; uniform ivec2 gpu_size;
+    uniform vec2 gpu_output; uniform int gpu_lanes;
+    out vec4 gpu_value; ${1}
+
+    vec2 position( vec4 v, ivec2 id, int lane ){ ${2} }
+    vec4 value   ( vec4 v, ivec2 id, int lane ){ ${3} }
+
+    void main(){
+        int   e  = gl_VertexID / gpu_lanes; int lane = gl_VertexID - e * gpu_lanes;
+        ivec2 id = ivec2( e % gpu_size.x, e / gpu_size.x );
+        vec4  v  = texelFetch( src, id, 0 );
+        vec2  p  = ( floor( position( v, id, lane ) ) + 0.5 ) / gpu_output;
+        gl_Position = vec4( p * 2.0 - 1.0, 0.0, 1.0 ); gpu_value = value( v, id, lane );
+    }
+);}}
+
+namespace nodepp { namespace gpu { string_t _scatter_fragment_=GPU_KERNEL(
+    ${0} in vec4 gpu_value; void main(){ gl_FragColor = gpu_value; }
+);}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { class scatter_t {
+protected:
+
+    struct NODE {
+        ptr_t<RL::RenderTexture2D> texture;
+        ptr_t<RL::Shader> /*-----*/ shader;
+        string_t position, value, library;
+        uint vao=0, lanes=1; /*----------*/
+        ulong /*-----------*/ generation=0;
+        bool /*-----------------*/ state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    /* programs linked before a cache::clear() have been unloaded */
+    bool is_stale() const noexcept {
+        return obj->shader.null() || obj->generation!=cache::_generation_;
+    }
+
+    void set_uniform( const char* name, const void* value, int type ) const {
+        auto loc = RL::rlGetLocationUniform( obj->shader->id, name );
+        if ( loc>=0 ){ RL::rlSetUniform( loc, value, type, 1 ); }
+    }
+
+    /* raw point draw with ONE,ONE blending, outside raylib's quad batch */
+    void draw( const RL::RenderTexture2D& target, const RL::Texture2D& input ) const {
+        auto gl = RL::GL::Load(); int w = target.texture.width, h = target.texture.height;
+        int  size[2] = { input.width, input.height }; float out[2] = { (float) w, (float) h };
+        int  zero    = 0; int lanes = obj->lanes;
+
+        if( obj->vao==0 ){ obj->vao = RL::rlLoadVertexArray(); }
+
+        RL::rlDrawRenderBatchActive(); RL::rlEnableFramebuffer( target.id );
+        RL::rlViewport( 0, 0, w, h ); RL::rlClearColor( 0, 0, 0, 0 ); RL::rlClearScreenBuffers();
+
+        RL::rlEnableShader( obj->shader->id ); RL::rlActiveTextureSlot( 0 ); RL::rlEnableTexture( input.id );
+        set_uniform( "src"       , &zero , RL::RL_SHADER_UNIFORM_INT   );
+        set_uniform( "gpu_size"  , size  , RL::RL_SHADER_UNIFORM_IVEC2 );
+        set_uniform( "gpu_output", out   , RL::RL_SHADER_UNIFORM_VEC2  );
+        set_uniform( "gpu_lanes" , &lanes, RL::RL_SHADER_UNIFORM_INT   );
+
+        RL::rlSetBlendFactors( RL::GL::ONE, RL::GL::ONE, RL::GL::FUNC_ADD );
+        RL::rlSetBlendMode   ( RL::RL_BLEND_CUSTOM );
+
+        RL::rlEnableVertexArray( obj->vao );
+        gl->DrawArrays( RL::GL::POINTS, 0, input.width * input.height * obj->lanes );
+        RL::rlDisableVertexArray();
+
+        RL::rlSetBlendMode( RL::RL_BLEND_ALPHA ); RL::rlDisableTexture();
+        RL::rlDisableShader(); RL::rlDisableFramebuffer();
+    }
+
+public:
+
+    scatter_t( string_t position, string_t value="return vec4( 1.0 );" ) : obj( new NODE() ) {
+        obj->position = position; obj->value = value;
+    }
+
+    scatter_t() noexcept : obj( new NODE() ){ obj->state = 0; }
+    virtual ~scatter_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+    void /**/close() const noexcept { /*---------*/ free(); }
+
+    void free() const noexcept { if( !is_closed() ){
+        if( !obj->texture.null() ){ pool::put_target( *obj->texture ); }
+        if( obj->vao!=0 && _gpu_ ){ RL::rlUnloadVertexArray( obj->vao ); }
+        /**/ obj->state = 0; /*--------------------------------------*/
+    }}
+
+    /*─······································································─*/
+
+    /* blending only accumulates on float attachments: OUT_FLOAT* or OUT_DOUBLE* */
+    scatter_t& set_output( uint width, uint height, uint format=OUT_DOUBLE4 ) {
+        if( get_depth( format )<2 ){ throw except_t("scatter needs a float output"); }
+        if( !obj->texture.null() ){ pool::put_target( *obj->texture ); }
+        obj->texture = type::bind( pool::get_target( width, height, format ) );
+        return *this;
+    }
+
+    scatter_t& set_lanes( uint lanes ) {
+        if( lanes==0 ){ throw except_t("invalid scatter lanes"); }
+        obj->lanes = lanes; return *this;
+    }
+
+    scatter_t& set_library( string_t source ) noexcept {
+        if( obj->library==source ){ return *this; }
+        obj->library = source; obj->shader = ptr_t<RL::Shader>(); return *this;
+    }
+
+    scatter_t& compile() {
+        obj->shader = cache::get(
+            regex::format( _scatter_fragment_, GLSL_VERSION ),
+            regex::format( _scatter_vertex_  , GLSL_VERSION, obj->library, obj->position, obj->value )
+        );  obj->generation = cache::_generation_; return *this;
+    }
+
+    /*─······································································─*/
+
+    RL::Texture2D render( const matrix_t& input ) { if( !is_closed() ){
+        if( obj->texture.null() ){ throw except_t("invalid texture"); }
+        if( is_stale() /*---*/ ){ compile(); /*-------------------*/ }
+        draw( *obj->texture, input.get() ); return obj->texture->texture;
+    } throw except_t( "scatter kernel closed" ); }
+
+    matrix_t operator()( const matrix_t& input ) { return matrix_t( render( input ) ); }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+namespace nodepp { namespace gpu { namespace cpu {
+
+    /* per-chunk private bins merged under one lock, same binning as the point draw */
+    matrix_t histogram( const matrix_t& input, uint bins ) {
+        uint lanes = get_channels( input.format() ), fmt = input.format();
+        const uchar* src = &input.raw(); matrix_t out( bins, 1, OUT_DOUBLE4 );
+        float* dst = (float*) &out.raw(); std::mutex mtx;
+
+        parallel_for( (ulong) input.width() * input.height(), [&]( ulong begin, ulong end ){
+            ptr_t<float> local( (ulong) bins * 4, 0.0f ); float v[4];
+            for( ulong i=begin; i<end; ++i ){ load( src, i, fmt ).store( v );
+            for( uint  l=0; l<lanes; ++l ){
+                 float x = v[l] < 0 ? 0 : v[l] > 1 ? 1 : v[l]; uint b = (uint)( x * bins );
+                 local[ ( b < bins ? b : bins - 1 ) * 4 + l ] += 1.0f;
+            }}
+            std::lock_guard<std::mutex> lock( mtx );
+            for( ulong x=0; x<local.size(); ++x ){ dst[x] += local[x]; }
+        }, 1 + GPU_CPU_GRAIN * 4 );
+
+        return out;
+    }
+
+}}}
+
+/*─······································································─*/
+
+namespace nodepp { namespace gpu {
+
+    /* bins x 1 RGBA32F: channel c of texel b counts input channel c in bin b,
+       values are expected in [0,1] as sampled */
+    matrix_t histogram( const matrix_t& input, uint bins ) {
+        if( bins==0 ){ throw except_t("invalid histogram bins"); }
+        if( !_gpu_ ){ return cpu::histogram( input, bins ); }
+
+        scatter_t kernel( GPU_KERNEL(
+            float x = clamp( v[lane], 0.0, 1.0 );
+            return vec2( min( floor( x * GPU_BINS ), GPU_BINS - 1.0 ), 0.0 );
+        ), GPU_KERNEL(
+            vec4 o = vec4( 0.0 ); o[lane] = 1.0; return o;
+        ));
+
+        kernel.set_library( regex::format( "\n#define GPU_BINS ${0}.0\n", string::to_string( bins ) ) )
+              .set_lanes  ( get_channels( input.format() ) )
+              .set_output ( bins, 1, OUT_DOUBLE4 );
+
+        return kernel( input );
+    }
+
+}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif
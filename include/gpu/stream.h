@@ -0,0 +1,298 @@
+/*
+ * Copyright 2023 The Nodepp Project Authors. All Rights Reserved.
+ *
+ * Licensed under the MIT (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://github.com/NodeppOfficial/nodepp/blob/main/LICENSE
+ */
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef NODEPP_GPU_STREAM
+#define NODEPP_GPU_STREAM
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#include "gpu.h"
+#include "pipeline.h"
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#ifndef GPU_STREAM_DEPTH
+#define GPU_STREAM_DEPTH 3 // frames between upload and readback
+#endif
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+/* frames in, processed frames out. Every frame owns a slot: an unpack PBO
+   and input texture, an output target and a readback PBO. Slots rotate, so
+   the upload of frame N+1, the draw of frame N and the readback of frame
+   N-1 sit in the GL queue together and the CPU only touches fenced data */
+namespace nodepp { namespace gpu { class stream_t {
+protected:
+
+    struct SLOT {
+        unsigned int pbo=0; ulong size=0;
+        RL::Texture2D       input = { 0 };
+        RL::RenderTexture2D output= { 0 };
+        ptr_t<gpu_t::PBO>   read;
+        matrix_t /*------*/ result;
+    };
+
+    struct NODE {
+        gpu_t    kernel  ; string_t input;
+        pipeline_t pipeline; bool piped=0;
+        ptr_t<gpu_t::DONE> saved; bool bound=0;
+        array_t<ptr_t<SLOT>> idle, busy;
+        array_t<matrix_t>    queue;
+        unsigned int fbo=0; uint depth=GPU_STREAM_DEPTH;
+        bool full=0, ending=0, task=0, state=1;
+    };  ptr_t<NODE> obj;
+
+    /*─······································································─*/
+
+    /* the kernel whose PBO ring and stats the readbacks go through */
+    gpu_t get_reader() const noexcept {
+        if( !obj->piped ){ return obj->kernel; }
+        auto& stages = obj->pipeline.obj->stages;
+        return stages[ stages.size()-1 ].kernel;
+    }
+
+    /* the first frame takes over the kernel's input, free() hands back
+       whatever the caller had bound under that name before */
+    void bind_input() const {
+        if( obj->bound ){ return; } auto& node = obj->kernel.obj; obj->bound = 1;
+        if( node->vars.has( obj->input ) ){ obj->saved = type::bind( node->vars[ obj->input ] ); }
+    }
+
+    void unbind_input() const noexcept {
+        if( !obj->bound ){ return; } auto& node = obj->kernel.obj; obj->bound = 0;
+        if( obj->saved.null() ){ node->vars.erase( obj->input ); node->shader = ptr_t<RL::Shader>(); return; }
+
+        auto item = *obj->saved; item.version = ++node->version; obj->saved = ptr_t<gpu_t::DONE>();
+        if( !node->vars.has( obj->input ) || node->vars[ obj->input ].type!=item.type )
+          { node->shader = ptr_t<RL::Shader>(); }
+        node->vars[ obj->input ] = item;
+    }
+
+    template< class T >
+    void set_source( const T& input ) const { stream_t self = *this;
+        onDrain.on([=](){ input.resume(); }); input.onClose.on([=](){ self.end(); });
+    }
+
+    /*─······································································─*/
+
+    void upload( SLOT& slot, const matrix_t& frame ) const {
+        auto gl = RL::GL::Load(); auto time = stats::now();
+        auto img = frame.get_image(); ulong size = RL::GetPixelDataSize( img.width, img.height, img.format );
+
+        if( slot.input.id==0 || slot.input.width!=img.width ||
+            slot.input.height!=img.height || slot.input.format!=img.format
+        ) { if( slot.input.id!=0 ){ pool::put_texture( slot.input ); }
+            slot.input = pool::get_texture( img.width, img.height, img.format );
+        }
+
+        if( slot.pbo==0 ){ gl->GenBuffers( 1, &slot.pbo ); }
+        gl->BindBuffer( RL::GL::PIXEL_UNPACK_BUFFER, slot.pbo );
+
+        // orphaning the store lets the driver hand out fresh memory while
+        // the previous upload from this slot may still be in flight
+        gl->BufferData( RL::GL::PIXEL_UNPACK_BUFFER, size, nullptr, RL::GL::STREAM_DRAW ); slot.size = size;
+        auto data = gl->MapBufferRange( RL::GL::PIXEL_UNPACK_BUFFER, 0, size,
+                                        RL::GL::MAP_WRITE_BIT | RL::GL::MAP_INVALIDATE_BUFFER_BIT );
+
+        if( data==nullptr ){ gl->BindBuffer( RL::GL::PIXEL_UNPACK_BUFFER, 0 ); throw except_t( "gpu upload failed" ); }
+        memcpy( data, img.data, size ); gl->UnmapBuffer( RL::GL::PIXEL_UNPACK_BUFFER );
+
+        gl->PixelStorei( RL::GL::UNPACK_ALIGNMENT, 1 ); // data is an offset into the PBO
+        RL::rlUpdateTexture( slot.input.id, 0, 0, img.width, img.height, img.format, nullptr );
+        gl->BindBuffer( RL::GL::PIXEL_UNPACK_BUFFER, 0 );
+
+        stats::scope_t scope( &get_reader().obj->stats );
+        stats::add_upload( stats::now() - time, size );
+    }
+
+    void dispatch( SLOT& slot ) const {
+        if( obj->piped ){
+            auto out = obj->pipeline.render( slot.input ); // lands on the last stage's target
+            RL::RenderTexture2D target = { 0 }; target.id = obj->fbo; target.texture = out;
+
+            RL::rlFramebufferAttach( obj->fbo, out.id, RL::RL_ATTACHMENT_COLOR_CHANNEL0, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+            slot.read = get_reader().issue_readback( target );
+            RL::rlFramebufferAttach( obj->fbo, 0, RL::RL_ATTACHMENT_COLOR_CHANNEL0, RL::RL_ATTACHMENT_TEXTURE2D, 0 );
+            return;
+        }
+
+        auto& kernel = obj->kernel; auto& node = kernel.obj;
+        if( node->texture.null() ){ throw except_t("invalid texture"); }
+
+        if( slot.output.id==0 || slot.output.texture.width!=(int) node->width ||
+            slot.output.texture.height!=(int) node->height || slot.output.texture.format!=(int) node->format
+        ) { if( slot.output.id!=0 ){ pool::put_target( slot.output ); }
+            slot.output = pool::get_target( node->width, node->height, node->format );
+        }
+
+        bind_input(); kernel.set_input( slot.input, obj->input );
+        if( kernel.is_tiled() ){ throw except_t("stream does not support tiled kernels"); }
+        kernel.render( slot.output ); slot.read = kernel.issue_readback( slot.output );
+    }
+
+    /* no GL context: the frame runs through the kernel's CPU fallback */
+    void run_fallback( SLOT& slot, const matrix_t& frame ) const {
+        if( obj->piped ){ throw except_t("gpu machine not started"); }
+        bind_input(); obj->kernel.set_input( frame, obj->input ); slot.result = obj->kernel();
+    }
+
+    /*─······································································─*/
+
+    void submit() const {
+        while( !obj->queue.empty() && obj->busy.size()<obj->depth ){
+            ptr_t<SLOT> slot; auto frame = obj->queue[0]; obj->queue.shift();
+            if( obj->idle.empty() ){ slot = ptr_t<SLOT>( new SLOT() ); }
+            else { slot = obj->idle[ obj->idle.size()-1 ]; obj->idle.pop(); }
+            obj->busy.push( slot ); /*------------------------------------*/
+
+            if( !_gpu_ ){ run_fallback( *slot, frame ); continue; }
+            if( obj->piped && obj->fbo==0 ){ obj->fbo = RL::rlLoadFramebuffer(); }
+            upload( *slot, frame ); dispatch( *slot );
+        }
+    }
+
+    /* false while the oldest frame is still on the GPU */
+    bool receive() const {
+        auto slot = obj->busy[0];
+
+        if( _gpu_ && !slot->read.null() ){
+            auto read = slot->read; auto gl = RL::GL::Load(); if( read->fence!=nullptr ){
+            auto state= gl->ClientWaitSync( read->fence, 0, 0 );
+            if  ( state == RL::GL::TIMEOUT_EXPIRED ){ return false; }
+            if  ( state == RL::GL::WAIT_FAILED ){ gpu_t::clear_readback( *read );
+                  slot->read = ptr_t<gpu_t::PBO>(); throw except_t( "gpu readback failed" );
+            }}    slot->result = get_reader().finish_readback( read ); slot->read = ptr_t<gpu_t::PBO>();
+        }
+
+        auto frame = slot->result; slot->result = matrix_t();
+        obj->busy.shift(); obj->idle.push( slot ); onData.emit( frame ); return true;
+    }
+
+    void next() const {
+        if( obj->task ){ return; } obj->task = 1; stream_t self = *this;
+        process::add([=](){
+            if( self.is_closed() ){ return -1; }
+
+            try { self.submit(); while( !self.obj->busy.empty() && self.receive() ){ self.submit(); } }
+            catch( except_t err ){ self.onError.emit( err ); self.close(); return -1; }
+
+            if( self.obj->full && self.obj->busy.size()+self.obj->queue.size()<self.obj->depth )
+              { self.obj->full = 0; self.onDrain.emit(); }
+
+            if( !self.obj->busy.empty() || !self.obj->queue.empty() ){ return 1; }
+            self.obj->task = 0; if( self.obj->ending ){ self.close(); } return -1;
+        });
+    }
+
+public:
+
+    event_t<matrix_t> onData ; // processed frames, in submission order
+    event_t<>         onDrain; // room for more frames after write() returned false
+    event_t<except_t> onError;
+    event_t<>         onClose;
+
+    /*─······································································─*/
+
+    stream_t( gpu_t kernel, string_t input, uint depth=GPU_STREAM_DEPTH ) : obj( new NODE() ) {
+        if( input.empty() ){ throw except_t("invalid variable name"); }
+        if( depth==0 ){ throw except_t("invalid stream depth"); }
+        obj->kernel = kernel; obj->input = input; obj->depth = depth;
+    }
+
+    stream_t( pipeline_t pipeline, uint depth=GPU_STREAM_DEPTH ) : obj( new NODE() ) {
+        if( pipeline.size()==0 ){ throw except_t("empty pipeline"); }
+        if( depth==0 ){ throw except_t("invalid stream depth"); }
+        obj->pipeline = pipeline; obj->piped = 1; obj->depth = depth;
+    }
+
+    stream_t() noexcept : obj( new NODE() ){ obj->state = 0; }
+    virtual ~stream_t() noexcept { if( obj.count()>1 ){ return; } free(); }
+
+    /*─······································································─*/
+
+    bool is_closed() const noexcept { return obj->state==0; }
+
+    void close() const noexcept {
+        if( is_closed() ){ return; } free(); onClose.emit();
+    }
+
+    void free() const noexcept { if( !is_closed() ){ obj->state = 0;
+        auto gl = _gpu_ ? RL::GL::Load() : nullptr; unbind_input();
+
+        for( auto& x: obj->busy ){ obj->idle.push( x ); } obj->busy.clear();
+        for( auto& x: obj->idle ){ if( gl==nullptr ){ continue; }
+             if( !x->read.null() ){ gpu_t::clear_readback( *x->read ); }
+             if( x->pbo!=0 ){ gl->DeleteBuffers( 1, &x->pbo ); }
+             if( x->input .id!=0 ){ pool::put_texture( x->input  ); }
+             if( x->output.id!=0 ){ pool::put_target ( x->output ); }
+        }    obj->idle.clear(); obj->queue.clear();
+
+        if( obj->fbo!=0 && gl!=nullptr ){ RL::rlUnloadFramebuffer( obj->fbo ); obj->fbo = 0; }
+    }}
+
+    /*─······································································─*/
+
+    /* queues a frame; false once `depth` frames are waiting or in flight,
+       the caller should then hold further frames until onDrain */
+    bool write( const matrix_t& frame ) const {
+        if( is_closed() ){ throw except_t("gpu stream closed"); }
+        if( obj->ending ){ throw except_t("gpu stream ended"); }
+
+        obj->queue.push( frame ); try { submit(); } // uploads start right away
+        catch( except_t err ){ onError.emit( err ); close(); return false; } next();
+        if( obj->busy.size()+obj->queue.size()<obj->depth ){ return true; }
+        obj->full = 1; return false;
+    }
+
+    /* closes the stream once every queued frame has been emitted */
+    void end() const { if( is_closed() ){ return; } obj->ending = 1;
+        if( obj->task ){ return; } close();
+    }
+
+    /* feeds frames from any readable that emits matrix_t on onData; the
+       source is stopped while write() pushes back and resumed on onDrain */
+    template< class T >
+    stream_t& pipe( const T& input ) {
+        stream_t self = *this; set_source( input );
+        input.onData.on([=]( matrix_t frame ){
+            if( self.is_closed() || self.obj->ending ){ return; }
+            if( !self.write( frame ) ){ input.stop(); }
+        }); return *this;
+    }
+
+    /* raw frames from a byte readable, e.g. a decoder's stdout or a socket:
+       chunks are cut into width x height frames of `format`, a trailing
+       partial frame is dropped when the source closes */
+    template< class T >
+    stream_t& pipe( const T& input, uint width, uint height, uint format ) {
+        ulong size = (ulong) width * height * gpu::get_channels( format ) * gpu::get_depth( format );
+        if( size==0 ){ throw except_t("invalid frame format"); }
+
+        stream_t self = *this; set_source( input ); ptr_t<string_t> buffer = new string_t();
+        input.onData.on([=]( string_t chunk ){ *buffer += chunk;
+            while( buffer->size()>=size && !self.is_closed() && !self.obj->ending ){
+                auto data = buffer->slice( 0, size ); *buffer = buffer->slice( size );
+                matrix_t frame( width, height, ptr_t<uchar>( (uchar*) data.get(), size ), format );
+                if( !self.write( frame ) ){ input.stop(); }
+            }
+        }); return *this;
+    }
+
+    /*─······································································─*/
+
+    uint  get_depth() const noexcept { return obj->depth; }
+    ulong size     () const noexcept { return obj->busy.size() + obj->queue.size(); }
+
+};}}
+
+/*────────────────────────────────────────────────────────────────────────────*/
+
+#endif